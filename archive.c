@@ -0,0 +1,76 @@
+/**
+ * @file archive.c
+ * @brief Implements the archive of expired batches.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vaccine.h"
+#include "inoculation.h"
+#include "archive.h"
+
+
+void start_archive(Archive *archive) {
+    archive->batches = NULL;
+    archive->count = START;
+    archive->size = START;
+    archive->reclaim = START;
+}
+
+
+void free_archive(Archive *archive) {
+    int i;
+    for (i = 0; i < archive->count; i++)
+        free_vaccine(archive->batches[i]);
+    free(archive->batches);
+    archive->batches = NULL;
+    archive->count = START;
+    archive->size = START;
+}
+
+
+/**
+ * @brief Finds the position of a batch code in the archive, or where it would go.
+ */
+static int archive_position(Archive *archive, BatchKey *key, char *batch) {
+    int mid, left = START, right = archive->count;
+
+    while (left < right) {
+        mid = (left + right) / 2;
+        if (compare_batch(&archive->batches[mid]->key, archive->batches[mid]->batch, key, batch) < 0)
+            left = mid + 1;
+        else right = mid;
+    }
+    return left;
+}
+
+
+void archive_add(Archive *archive, Vaccine *vaccine) {
+    int i;
+
+    if (archive->count == archive->size) {
+        archive->size = (archive->size == 0) ? NUM_ARCHIVED : archive->size * 2;
+        archive->batches = realloc(archive->batches, sizeof(Vaccine*) * archive->size);
+    }
+    i = archive_position(archive, &vaccine->key, vaccine->batch);
+    memmove(archive->batches + i + 1, archive->batches + i, sizeof(Vaccine*) * (archive->count - i));
+    archive->batches[i] = vaccine;
+    archive->count++;
+}
+
+
+Vaccine *archive_find(Archive *archive, char *batch) {
+    int i;
+    BatchKey key;
+
+    pack_batch(batch, &key);
+    i = archive_position(archive, &key, batch);
+    if (i < archive->count && compare_batch(&archive->batches[i]->key, archive->batches[i]->batch, &key, batch) == 0)
+        return archive->batches[i];
+    return NULL;
+}
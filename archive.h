@@ -0,0 +1,73 @@
+/**
+ * @file archive.h
+ * @brief Header file for the archive of expired batches.
+ *
+ * When reclamation is on, `t` takes the batches that expired out of the batch
+ * list. Those never used are freed; those used move here, since their
+ * inoculations keep pointing at them, and stay out of `l`, of the scans of
+ * `a` and of the batch limit. The archive is sorted by batch code, so `b`,
+ * `r` and the duplicate check of `c` still find them.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vaccine.h"
+
+#define NUM_ARCHIVED 64     /**< Initial size of the archive */
+
+
+/**
+ * @brief Expired batches taken out of the batch list.
+ */
+typedef struct {
+    Vaccine **batches;      /**< Archived batches, sorted by batch code */
+    int count;              /**< Number of archived batches */
+    int size;               /**< Size of the table of batches */
+    int reclaim;            /**< Non-zero if `t` reclaims the expired batches */
+} Archive;
+
+
+/**
+ * @brief Initializes an empty archive, with reclamation off.
+ *
+ * @param archive Pointer to the archive.
+ */
+void start_archive(Archive *archive);
+
+
+/**
+ * @brief Frees the archive and its batches.
+ *
+ * @param archive Pointer to the archive.
+ */
+void free_archive(Archive *archive);
+
+
+/**
+ * @brief Adds a batch to the archive.
+ *
+ * @param archive Pointer to the archive.
+ * @param vaccine The batch, no longer in the batch list.
+ */
+void archive_add(Archive *archive, Vaccine *vaccine);
+
+
+/**
+ * @brief Finds an archived batch by its code.
+ *
+ * @param archive Pointer to the archive.
+ * @param batch Batch code.
+ * @return The batch, or NULL if it is not archived.
+ */
+Vaccine *archive_find(Archive *archive, char *batch);
+
+
+#endif
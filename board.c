@@ -0,0 +1,131 @@
+/**
+ * @file board.c
+ * @brief Implements the published catalog and its reader.
+ *
+ * Every write section is flushed in three steps (odd header, records, even
+ * header), so a reader that sees the same even sequence number on both sides
+ * of its copy knows no write happened in between.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "board.h"
+
+
+void start_board(Board *board) {
+    board->file = NULL;
+    memset(&board->header, 0, sizeof(BoardHeader));
+}
+
+
+/**
+ * @brief Writes the header with the current sequence number.
+ */
+static void write_header(Board *board) {
+    fseek(board->file, 0, SEEK_SET);
+    fwrite(&board->header, sizeof(BoardHeader), 1, board->file);
+    fflush(board->file);
+}
+
+
+/**
+ * @brief Writes a batch at its position.
+ */
+static void write_record(Board *board, Vaccine *vaccine, int pos) {
+    BoardRecord record;
+
+    memset(&record, 0, sizeof(BoardRecord));
+    strcpy(record.name, vaccine->name);
+    strcpy(record.batch, vaccine->batch);
+    record.day = vaccine->date.day;
+    record.month = vaccine->date.month;
+    record.year = vaccine->date.year;
+    record.dose = vaccine->dose;
+    record.uses = vaccine->uses;
+    fseek(board->file, sizeof(BoardHeader) + (long) pos * sizeof(BoardRecord), SEEK_SET);
+    fwrite(&record, sizeof(BoardRecord), 1, board->file);
+}
+
+
+int open_board(Board *board, char *path, Vaccine *batch_list[], int entries) {
+    FILE *file = fopen(path, "w+b");
+    BoardRecord empty;
+    int i;
+
+    if (file == NULL) return INVALID;
+    close_board(board);
+    board->file = file;
+    memcpy(board->header.magic, BOARD_MAGIC, MAGIC_SIZE);
+    board->header.layout = BOARD_LAYOUT;
+    board->header.record_size = sizeof(BoardRecord);
+    board->header.capacity = MAX_BRATCH;
+    board->header.entries = 0;
+
+    write_header(board);
+    memset(&empty, 0, sizeof(BoardRecord));     /* The file has its full size from the start */
+    for (i = 0; i < MAX_BRATCH; i++)
+        fwrite(&empty, sizeof(BoardRecord), 1, file);
+    publish_all(board, batch_list, entries);
+    return VALID;
+}
+
+
+void close_board(Board *board) {
+    if (board->file != NULL) fclose(board->file);
+    board->file = NULL;
+}
+
+
+void publish_all(Board *board, Vaccine *batch_list[], int entries) {
+    int i;
+
+    if (board->file == NULL) return;
+    board->header.seq++;
+    write_header(board);
+    for (i = 0; i < entries; i++)
+        write_record(board, batch_list[i], i);
+    fflush(board->file);
+    board->header.entries = entries;
+    board->header.seq++;
+    write_header(board);
+}
+
+
+void publish_batch(Board *board, Vaccine *vaccine, int pos) {
+    if (board->file == NULL) return;
+    board->header.seq++;
+    write_header(board);
+    write_record(board, vaccine, pos);
+    fflush(board->file);
+    board->header.seq++;
+    write_header(board);
+}
+
+
+int read_board(FILE *file, BoardHeader *header, BoardRecord records[]) {
+    int tries;
+    BoardHeader after;
+
+    for (tries = 0; tries < BOARD_RETRIES; tries++) {
+        fseek(file, 0, SEEK_SET);       /* Also drops what the stream had buffered */
+        if (fread(header, sizeof(BoardHeader), 1, file) != 1 ||
+                memcmp(header->magic, BOARD_MAGIC, MAGIC_SIZE) != 0 ||
+                header->layout != BOARD_LAYOUT || header->record_size != sizeof(BoardRecord) ||
+                header->entries < 0 || header->entries > MAX_BRATCH)
+            return INVALID;
+        if (header->seq % 2 != 0) continue;     /* A write is in progress */
+
+        if ((int) fread(records, sizeof(BoardRecord), header->entries, file) != header->entries) continue;
+        fseek(file, 0, SEEK_SET);
+        if (fread(&after, sizeof(BoardHeader), 1, file) == 1 && after.seq == header->seq)
+            return VALID;
+    }
+    return INVALID;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file board.h
+ * @brief Header file for the published catalog read by other processes.
+ *
+ * The board is a file with a fixed layout and no pointers: a header followed
+ * by room for MAX_BRATCH batch records, in the order of the batch list. The
+ * running program rewrites it whenever a batch changes; other programs read
+ * it (or map it) without replaying any command.
+ *
+ * Consistency follows a sequence lock: the writer makes the sequence number
+ * odd before changing the records and even again afterwards, and a reader
+ * keeps a copy only if it saw the same even number before and after reading.
+ *
+ * This module only depends on the standard library, so readers can be built
+ * with board.c alone.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+
+#define BOARD_MAGIC     "VACBOARD"  /**< First bytes of a board file */
+#define MAGIC_SIZE      8           /**< Length of the magic string */
+#define BOARD_LAYOUT    1           /**< Version of the file layout */
+#define BOARD_RETRIES   100000      /**< Reads attempted before giving up on a writer that never pauses */
+
+
+/**
+ * @brief Header at the start of a board file.
+ */
+typedef struct {
+    char magic[MAGIC_SIZE];     /**< BOARD_MAGIC, without terminator */
+    unsigned int layout;        /**< BOARD_LAYOUT */
+    unsigned int record_size;   /**< Size of one BoardRecord */
+    unsigned long long seq;     /**< Sequence number, odd while the records change */
+    int entries;                /**< Number of batches */
+    int capacity;               /**< Records the file has room for */
+} BoardHeader;
+
+
+/**
+ * @brief One batch as stored in the board.
+ */
+typedef struct {
+    char name[NAME_SIZE];       /**< Vaccine name */
+    char batch[BATCH_SIZE];     /**< Batch code */
+    int day;                    /**< Expiration day */
+    int month;                  /**< Expiration month */
+    int year;                   /**< Expiration year */
+    int dose;                   /**< Doses available */
+    int uses;                   /**< Doses already applied */
+} BoardRecord;
+
+
+/**
+ * @brief Board kept up to date by the running program.
+ */
+typedef struct {
+    FILE *file;                 /**< Board file, or NULL if the catalog is not published */
+    BoardHeader header;         /**< Header as last written */
+} Board;
+
+
+/**
+ * @brief Initializes a board that is not published.
+ *
+ * @param board Pointer to the board.
+ */
+void start_board(Board *board);
+
+
+/**
+ * @brief Creates a board file and publishes the batches in it.
+ *
+ * @param board Pointer to the board.
+ * @param path Path of the file, created or truncated.
+ * @param batch_list Sorted array of batches.
+ * @param entries Number of batches.
+ * @return VALID, or INVALID if the file cannot be created.
+ */
+int open_board(Board *board, char *path, Vaccine *batch_list[], int entries);
+
+
+/**
+ * @brief Closes the board file.
+ *
+ * @param board Pointer to the board.
+ */
+void close_board(Board *board);
+
+
+/**
+ * @brief Rewrites every batch, after batches were added or removed.
+ *
+ * @param board Pointer to the board.
+ * @param batch_list Sorted array of batches.
+ * @param entries Number of batches.
+ */
+void publish_all(Board *board, Vaccine *batch_list[], int entries);
+
+
+/**
+ * @brief Rewrites one batch whose doses changed.
+ *
+ * @param board Pointer to the board.
+ * @param vaccine The batch.
+ * @param pos Position of the batch in the batch list.
+ */
+void publish_batch(Board *board, Vaccine *vaccine, int pos);
+
+
+/**
+ * @brief Reads a consistent copy of a board.
+ *
+ * @param file Board file, opened for reading.
+ * @param header Receives the header.
+ * @param records Receives the records (room for MAX_BRATCH).
+ * @return VALID, or INVALID if the file is not a board or never stood still.
+ */
+int read_board(FILE *file, BoardHeader *header, BoardRecord records[]);
+
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file cache.c
+ * @brief Implements the cache of rendered `l` listings.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "catalog.h"
+#include "cache.h"
+
+
+void start_cache(ListCache *cache) {
+    memset(&cache->all, 0, sizeof(Rendered));
+    cache->names = NULL;
+    cache->num_names = 0;
+}
+
+
+void free_cache(ListCache *cache) {
+    int i;
+    for (i = 0; i < cache->num_names; i++)
+        free(cache->names[i].text);
+    free(cache->names);
+    free(cache->all.text);
+}
+
+
+void invalidate_name(ListCache *cache, int name_id) {
+    if (name_id >= 0 && name_id < cache->num_names) cache->names[name_id].valid = 0;
+    cache->all.valid = 0;
+}
+
+
+void invalidate_cache(ListCache *cache) {
+    int i;
+    for (i = 0; i < cache->num_names; i++)
+        cache->names[i].valid = 0;
+    cache->all.valid = 0;
+}
+
+
+/**
+ * @brief Renders batches in the format of print_list.
+ */
+static void render_list(Rendered *rendered, Vaccine *list[], int count) {
+    int i;
+    Vaccine *vaccine;
+
+    rendered->length = 0;
+    for (i = 0; i < count; i++) {
+        if (rendered->length + LINE_SIZE > rendered->size) {
+            rendered->size = (rendered->size == 0) ? RENDER_SIZE : rendered->size * 2;
+            rendered->text = realloc(rendered->text, rendered->size);
+        }
+        vaccine = list[i];
+        rendered->length += sprintf(rendered->text + rendered->length, "%s %s %s%d-%s%d-%d %d %d\n",
+                vaccine->name, vaccine->batch, Zero(vaccine->date.day), vaccine->date.day,
+                Zero(vaccine->date.month), vaccine->date.month, vaccine->date.year, vaccine->dose, vaccine->uses);
+    }
+    rendered->rows = count;
+    rendered->valid = 1;
+}
+
+
+void cache_print_all(ListCache *cache, Vaccine *batch_list[], int entries) {
+    if (!cache->all.valid) render_list(&cache->all, batch_list, entries);
+    if (cache->all.length > 0) fwrite(cache->all.text, 1, cache->all.length, stdout);
+}
+
+
+int cache_print_name(ListCache *cache, Catalog *catalog, Vaccine *batch_list[], int entries, int name_id) {
+    int i, count, found[MAX_BRATCH];
+    Vaccine *list[MAX_BRATCH];
+    Rendered *rendered;
+
+    if (name_id >= cache->num_names) {      /* A name interned after the table was sized */
+        cache->names = realloc(cache->names, sizeof(Rendered) * catalog->names_size);
+        memset(cache->names + cache->num_names, 0, sizeof(Rendered) * (catalog->names_size - cache->num_names));
+        cache->num_names = catalog->names_size;
+    }
+    rendered = &cache->names[name_id];
+    if (!rendered->valid) {
+        count = catalog_select(catalog, entries, name_id, found);
+        for (i = 0; i < count; i++)
+            list[i] = batch_list[found[i]];
+        render_list(rendered, list, count);
+    }
+    if (rendered->length > 0) fwrite(rendered->text, 1, rendered->length, stdout);
+    return rendered->rows;
+}
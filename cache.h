@@ -0,0 +1,106 @@
+/**
+ * @file cache.h
+ * @brief Header file for the cache of rendered `l` listings.
+ *
+ * Keeps the text printed by `l` and by `l <name>` for each vaccine name, so
+ * a repeated listing is a single write. Commands that change a batch
+ * invalidate the text of its vaccine and of the full listing.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "catalog.h"
+
+#define RENDER_SIZE 4096    /**< Initial size of a rendered text */
+#define LINE_SIZE   128     /**< Room for one rendered batch line */
+
+
+/**
+ * @brief Rendered text of one listing.
+ */
+typedef struct {
+    char *text;     /**< Text as printed */
+    int length;     /**< Length of the text */
+    int size;       /**< Allocated size of the text */
+    int rows;       /**< Number of batches listed */
+    int valid;      /**< Non-zero if the text is up to date */
+} Rendered;
+
+
+/**
+ * @brief Cache of the full listing and of the listing of each vaccine name.
+ */
+typedef struct {
+    Rendered all;       /**< Text of `l` */
+    Rendered *names;    /**< Text of `l <name>`, indexed by vaccine name id */
+    int num_names;      /**< Size of the table of names */
+} ListCache;
+
+
+/**
+ * @brief Initializes an empty cache.
+ *
+ * @param cache Pointer to the cache.
+ */
+void start_cache(ListCache *cache);
+
+
+/**
+ * @brief Frees every rendered text.
+ *
+ * @param cache Pointer to the cache.
+ */
+void free_cache(ListCache *cache);
+
+
+/**
+ * @brief Marks the listings of a vaccine name, and the full listing, as stale.
+ *
+ * @param cache Pointer to the cache.
+ * @param name_id Id of the vaccine name.
+ */
+void invalidate_name(ListCache *cache, int name_id);
+
+
+/**
+ * @brief Marks every listing as stale.
+ *
+ * @param cache Pointer to the cache.
+ */
+void invalidate_cache(ListCache *cache);
+
+
+/**
+ * @brief Prints the full listing, rendering it first if it is stale.
+ *
+ * @param cache Pointer to the cache.
+ * @param batch_list Sorted array of batches.
+ * @param entries Number of batches.
+ */
+void cache_print_all(ListCache *cache, Vaccine *batch_list[], int entries);
+
+
+/**
+ * @brief Prints the listing of a vaccine name, rendering it first if it is stale.
+ *
+ * @param cache Pointer to the cache.
+ * @param catalog Pointer to the catalog.
+ * @param batch_list Sorted array of batches.
+ * @param entries Number of batches.
+ * @param name_id Id of the vaccine name (not NO_NAME).
+ * @return Number of batches listed.
+ */
+int cache_print_name(ListCache *cache, Catalog *catalog, Vaccine *batch_list[], int entries, int name_id);
+
+
+#endif
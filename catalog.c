@@ -0,0 +1,204 @@
+/**
+ * @file catalog.c
+ * @brief Implements the column-oriented batch catalog and its scan kernels.
+ *
+ * The kernels test a whole block of batches with comparisons combined by
+ * bitwise operations, so the loops have no branches and are vectorized
+ * (SSE2, or AVX2 with -march=native) by the compiler. Only a block that
+ * holds a match is searched again with a scalar loop.
+ * 
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "catalog.h"
+
+
+void start_catalog(Catalog *catalog) {
+    catalog->num_names = 0;
+    catalog->names_size = NUM_NAMES;
+    catalog->names = malloc(sizeof(char*) * NUM_NAMES);
+}
+
+
+void free_catalog(Catalog *catalog) {
+    int i;
+    for (i = 0; i < catalog->num_names; i++)
+        free(catalog->names[i]);
+    free(catalog->names);
+}
+
+
+int find_name(Catalog *catalog, char *name) {
+    int i;
+    for (i = 0; i < catalog->num_names; i++) {
+        if (strcmp(catalog->names[i], name) == 0)
+            return i;
+    }
+    return NO_NAME;
+}
+
+
+int intern_name(Catalog *catalog, char *name) {
+    int id = find_name(catalog, name);
+    if (id != NO_NAME) return id;
+
+    if (catalog->num_names == catalog->names_size) {
+        catalog->names_size *= 2;
+        catalog->names = realloc(catalog->names, sizeof(char*) * catalog->names_size);
+    }
+    catalog->names[catalog->num_names] = strdup(name);
+    return catalog->num_names++;
+}
+
+
+void catalog_insert(Catalog *catalog, int pos, int entries, Vaccine *vaccine) {
+    int size = entries - pos;
+
+    memmove(&catalog->expiry[pos + 1], &catalog->expiry[pos], sizeof(int) * size);
+    memmove(&catalog->dose[pos + 1], &catalog->dose[pos], sizeof(int) * size);
+    memmove(&catalog->name_id[pos + 1], &catalog->name_id[pos], sizeof(int) * size);
+    memmove(&catalog->key_hi[pos + 1], &catalog->key_hi[pos], sizeof(unsigned long long) * size);
+    memmove(&catalog->key_lo[pos + 1], &catalog->key_lo[pos], sizeof(unsigned long long) * size);
+
+    catalog->expiry[pos] = date_to_day(vaccine->date);
+    catalog->dose[pos] = vaccine->dose;
+    catalog->name_id[pos] = vaccine->name_id = intern_name(catalog, vaccine->name);
+    catalog->key_hi[pos] = vaccine->key.hi;
+    catalog->key_lo[pos] = vaccine->key.lo;
+}
+
+
+void catalog_remove(Catalog *catalog, int pos, int entries) {
+    int size = entries - pos - 1;
+
+    memmove(&catalog->expiry[pos], &catalog->expiry[pos + 1], sizeof(int) * size);
+    memmove(&catalog->dose[pos], &catalog->dose[pos + 1], sizeof(int) * size);
+    memmove(&catalog->name_id[pos], &catalog->name_id[pos + 1], sizeof(int) * size);
+    memmove(&catalog->key_hi[pos], &catalog->key_hi[pos + 1], sizeof(unsigned long long) * size);
+    memmove(&catalog->key_lo[pos], &catalog->key_lo[pos + 1], sizeof(unsigned long long) * size);
+}
+
+
+void catalog_build(Catalog *catalog, Vaccine *batch_list[], int entries) {
+    int i;
+    for (i = 0; i < entries; i++) {
+        catalog->expiry[i] = date_to_day(batch_list[i]->date);
+        catalog->dose[i] = batch_list[i]->dose;
+        catalog->name_id[i] = batch_list[i]->name_id = intern_name(catalog, batch_list[i]->name);
+        catalog->key_hi[i] = batch_list[i]->key.hi;
+        catalog->key_lo[i] = batch_list[i]->key.lo;
+    }
+}
+
+
+/**
+ * @brief Tests whether a block of batches holds an eligible batch of a vaccine.
+ *
+ * The comparisons are combined with bitwise operations so the loop has no
+ * branches and is vectorized by the compiler.
+ *
+ * @return Non-zero if the block holds an eligible batch.
+ */
+static int block_eligible(const int *ids, const int *expiry, const int *dose, int size, int name_id, int today) {
+    int i, any = 0;
+    for (i = 0; i < size; i++)
+        any |= (ids[i] == name_id) & (expiry[i] > today) & (dose[i] > 0);
+    return any;
+}
+
+
+/**
+ * @brief Tests whether a block of batches holds a batch of a vaccine.
+ *
+ * @return Non-zero if the block holds a batch with that name id.
+ */
+static int block_named(const int *ids, int size, int name_id) {
+    int i, any = 0;
+    for (i = 0; i < size; i++)
+        any |= (ids[i] == name_id);
+    return any;
+}
+
+
+/**
+ * @brief Tests whether a block of batches holds a packed key.
+ *
+ * @return Non-zero if the block holds the key.
+ */
+static int block_key(const unsigned long long *hi, const unsigned long long *lo, int size, BatchKey key) {
+    int i, any = 0;
+    for (i = 0; i < size; i++)
+        any |= (hi[i] == key.hi) & (lo[i] == key.lo);
+    return any;
+}
+
+
+int catalog_find(Catalog *catalog, Vaccine *batch_list[], int entries, char *batch) {
+    int i, block, end;
+    BatchKey key;
+
+    if (pack_batch(batch, &key) != VALID) {     /* Falls back to string comparison */
+        for (i = 0; i < entries; i++) {
+            if (strcmp(batch_list[i]->batch, batch) == 0)
+                return i;
+        }
+        return NUM_NO_BATCH;
+    }
+
+    for (block = 0; block < entries; block += LANES) {
+        end = (block + LANES < entries) ? block + LANES : entries;
+        if (!block_key(catalog->key_hi + block, catalog->key_lo + block, end - block, key))
+            continue;
+        for (i = block; i < end; i++) {
+            if (catalog->key_hi[i] == key.hi && catalog->key_lo[i] == key.lo)
+                return i;
+        }
+    }
+    return NUM_NO_BATCH;
+}
+
+
+int catalog_first_eligible(Catalog *catalog, int entries, int name_id, int today) {
+    return catalog_next_eligible(catalog, 0, entries, name_id, today);
+}
+
+
+int catalog_next_eligible(Catalog *catalog, int first, int entries, int name_id, int today) {
+    int i, block, end;
+    const int *expiry = catalog->expiry, *dose = catalog->dose, *ids = catalog->name_id;
+
+    for (block = first; block < entries; block += LANES) {
+        end = (block + LANES < entries) ? block + LANES : entries;
+        if (!block_eligible(ids + block, expiry + block, dose + block, end - block, name_id, today))
+            continue;
+        for (i = block; i < end; i++) {     /* Scalar search inside the matching block */
+            if (ids[i] == name_id && expiry[i] > today && dose[i] > 0)
+                return i;
+        }
+    }
+    return NO_ELIGIBLE;
+}
+
+
+int catalog_select(Catalog *catalog, int entries, int name_id, int found[]) {
+    int i, block, end, count = 0;
+    const int *ids = catalog->name_id;
+
+    for (block = 0; block < entries; block += LANES) {
+        end = (block + LANES < entries) ? block + LANES : entries;
+        if (!block_named(ids + block, end - block, name_id))
+            continue;
+        for (i = block; i < end; i++) {
+            if (ids[i] == name_id)
+                found[count++] = i;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file catalog.h
+ * @brief Header file for the column-oriented batch catalog.
+ *
+ * Declares the `Catalog` structure, a structure-of-arrays copy of the fields
+ * of the batch list that are read by eligibility scans (expiry day, doses and
+ * vaccine name), kept in the same order as the batch list.
+ * 
+ * To be included by modules that filter vaccine batches.
+ * 
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+
+#define NUM_NAMES   64      /**< Initial size of the vaccine name table */
+#define LANES       64      /**< Batches tested per block by the scan kernels */
+#define NO_NAME     -1      /**< Id returned for an unknown vaccine name */
+#define NO_ELIGIBLE -1      /**< Index returned when no batch is eligible */
+
+
+/**
+ * @brief Column-oriented copy of the batch list used by the scan kernels.
+ *
+ * Position i of every column describes batch_list[i].
+ */
+typedef struct catalog {
+    int expiry[MAX_BRATCH];     /**< Expiration day number of each batch */
+    int dose[MAX_BRATCH];       /**< Available doses of each batch */
+    int name_id[MAX_BRATCH];    /**< Id of the vaccine name of each batch */
+    unsigned long long key_hi[MAX_BRATCH];  /**< High word of the packed batch key */
+    unsigned long long key_lo[MAX_BRATCH];  /**< Low word of the packed batch key */
+    char **names;               /**< Vaccine names, indexed by id */
+    int num_names;              /**< Number of known vaccine names */
+    int names_size;             /**< Allocated size of the name table */
+} Catalog;
+
+
+/**
+ * @brief Initializes an empty catalog.
+ *
+ * @param catalog Pointer to the catalog.
+ */
+void start_catalog(Catalog *catalog);
+
+
+/**
+ * @brief Frees the name table of the catalog.
+ *
+ * @param catalog Pointer to the catalog.
+ */
+void free_catalog(Catalog *catalog);
+
+
+/**
+ * @brief Returns the id of a vaccine name.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param name Vaccine name.
+ * @return The id of the name, or NO_NAME if it was never registered.
+ */
+int find_name(Catalog *catalog, char *name);
+
+
+/**
+ * @brief Returns the id of a vaccine name, registering it if needed.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param name Vaccine name.
+ * @return The id of the name.
+ */
+int intern_name(Catalog *catalog, char *name);
+
+
+/**
+ * @brief Inserts the columns of a batch at a position, shifting the following ones.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param pos Position of the batch in the batch list.
+ * @param entries Number of batches before the insertion.
+ * @param vaccine Pointer to the inserted batch.
+ */
+void catalog_insert(Catalog *catalog, int pos, int entries, Vaccine *vaccine);
+
+
+/**
+ * @brief Removes the columns of the batch at a position.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param pos Position of the batch in the batch list.
+ * @param entries Number of batches before the removal.
+ */
+void catalog_remove(Catalog *catalog, int pos, int entries);
+
+
+/**
+ * @brief Rebuilds every column from a sorted batch list in one pass.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param batch_list Sorted array of batches.
+ * @param entries Number of batches.
+ */
+void catalog_build(Catalog *catalog, Vaccine *batch_list[], int entries);
+
+
+/**
+ * @brief Finds the position of a batch by its code.
+ *
+ * Packed codes are matched against the key columns with the block kernel;
+ * codes that do not pack are compared as strings.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param batch_list The array of existing vaccine pointers.
+ * @param entries Number of batches.
+ * @param batch Batch code to search for.
+ * @return Position of the batch, or NUM_NO_BATCH if it does not exist.
+ */
+int catalog_find(Catalog *catalog, Vaccine *batch_list[], int entries, char *batch);
+
+
+/**
+ * @brief Finds the first batch of a vaccine that is not expired and still has doses.
+ *
+ * Batches are tested LANES at a time with a branch-free kernel that the
+ * compiler turns into SIMD code; only the first matching block is searched
+ * with a scalar loop.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param entries Number of batches.
+ * @param name_id Id of the vaccine name.
+ * @param today Day number of the current date.
+ * @return Position of the batch, or NO_ELIGIBLE if there is none.
+ */
+int catalog_first_eligible(Catalog *catalog, int entries, int name_id, int today);
+
+
+/**
+ * @brief Finds the first eligible batch of a vaccine from a position on.
+ *
+ * Batches before an eligible one that ran out stay ineligible, so a run of
+ * applications of one vaccine continues the search where it stopped.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param first Position where the search starts.
+ * @param entries Number of batches.
+ * @param name_id Id of the vaccine name.
+ * @param today Day number of the current date.
+ * @return Position of the batch, or NO_ELIGIBLE if there is none.
+ */
+int catalog_next_eligible(Catalog *catalog, int first, int entries, int name_id, int today);
+
+
+/**
+ * @brief Collects the positions of every batch of a vaccine.
+ *
+ * @param catalog Pointer to the catalog.
+ * @param entries Number of batches.
+ * @param name_id Id of the vaccine name.
+ * @param found Output array of positions (at least entries long).
+ * @return Number of positions found.
+ */
+int catalog_select(Catalog *catalog, int entries, int name_id, int found[]);
+
+
+#endif
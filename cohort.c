@@ -0,0 +1,49 @@
+/**
+ * @file cohort.c
+ * @brief Implements the application of one vaccine to a cohort of users.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+#include "user.h"
+#include "catalog.h"
+#include "system.h"
+#include "journal.h"
+#include "cohort.h"
+
+
+void start_cohort(Sys *sys, Cohort *cohort, char *vaccine) {
+    cohort->vaccine = vaccine;
+    cohort->name_id = find_name(&sys->catalog, vaccine);
+    cohort->today = date_to_day(sys->present);
+    cohort->batch = catalog_first_eligible(&sys->catalog, sys->entries, cohort->name_id, cohort->today);
+}
+
+
+void cohort_apply(Sys *sys, Cohort *cohort, char *name, int size) {
+    LinkInl record;
+
+    if (cohort->batch == NO_ELIGIBLE) {
+        puts(NO_STOCK(sys->language));
+        return;
+    }
+    if (comp_inoculation(sys->user, sys->inolink, sys->present, name, size, cohort->vaccine) != VALID) {
+        puts(ALREADY(sys->language));
+        return;
+    }
+    record = apply_dose(sys, cohort->batch, name, size, sys->present);
+    journal_inoculation(&sys->journal, record);
+    printf("%s\n", record->vaccine->batch);
+
+    if (sys->catalog.dose[cohort->batch] == 0)     /* Runs out, the next batch is later in the list */
+        cohort->batch = catalog_next_eligible(&sys->catalog, cohort->batch + 1, sys->entries,
+                cohort->name_id, cohort->today);
+}
@@ -0,0 +1,58 @@
+/**
+ * @file cohort.h
+ * @brief Header file for the application of one vaccine to a cohort of users.
+ *
+ * A cohort resolves the vaccine name and its oldest eligible batch once, and
+ * then hands out doses batch after batch in expiry order, moving to the next
+ * eligible batch only when the current one runs out. Each user gets the same
+ * result, printed in the same format, as a separate `a` command would give.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef COHORT_H
+#define COHORT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "system.h"
+
+#define COHORT_FILE '@'     /**< Prefix of a file with one user per line */
+
+
+/**
+ * @brief State of a cohort being vaccinated.
+ */
+typedef struct {
+    char *vaccine;          /**< Vaccine name */
+    int name_id;            /**< Id of the vaccine name in the catalog */
+    int today;              /**< Day number of the current date */
+    int batch;              /**< Position of the batch in use, or NO_ELIGIBLE */
+} Cohort;
+
+
+/**
+ * @brief Starts a cohort, finding the oldest eligible batch of the vaccine.
+ *
+ * @param sys Pointer to the system structure.
+ * @param cohort Pointer to the cohort.
+ * @param vaccine Vaccine name.
+ */
+void start_cohort(Sys *sys, Cohort *cohort, char *vaccine);
+
+
+/**
+ * @brief Applies a dose to the next user of the cohort and prints the result.
+ *
+ * @param sys Pointer to the system structure.
+ * @param cohort Pointer to the cohort.
+ * @param name User name.
+ * @param size Length of the user name.
+ */
+void cohort_apply(Sys *sys, Cohort *cohort, char *name, int size);
+
+
+#endif
@@ -0,0 +1,484 @@
+/**
+ * @file cold.c
+ * @brief Implements the cold tier of historical inoculations.
+ *
+ * Segments are written once, when `t` moves the date past the retention
+ * horizon, and then only read with fseek/fread. A segment holds its records
+ * in date order (for full listings and date ranges) and an index sorted by
+ * user name (binary searched for a single user).
+ * 
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+#include "user.h"
+#include "catalog.h"
+#include "cold.h"
+#include "export.h"
+
+
+/**
+ * @brief Inoculation being moved to a segment, with its position in date order.
+ */
+typedef struct {
+    LinkInl ino;            /**< Record in memory */
+    int pos;                /**< Position in the segment */
+} Spilled;
+
+
+/**
+ * @brief Compares two spilled inoculations by user name and then by position.
+ */
+static int comp_spill(const void *a, const void *b) {
+    const Spilled *spilled1 = a, *spilled2 = b;
+    int result = (spilled1->ino->name == spilled2->ino->name) ? 0 : strcmp(spilled1->ino->name, spilled2->ino->name);
+
+    if (result != 0) return result;
+    return spilled1->pos - spilled2->pos;
+}
+
+
+/**
+ * @brief Reads the record at a position of a segment.
+ */
+static void read_record(Segment *segment, int pos, ColdRecord *record) {
+    fseek(segment->file, (long) pos * sizeof(ColdRecord), SEEK_SET);
+    fread(record, sizeof(ColdRecord), 1, segment->file);
+}
+
+
+int read_records(Segment *segment, int first, ColdRecord records[]) {
+    int size = (segment->count - first < COLD_CHUNK) ? segment->count - first : COLD_CHUNK;
+
+    fseek(segment->file, (long) first * sizeof(ColdRecord), SEEK_SET);
+    fread(records, sizeof(ColdRecord), size, segment->file);
+    return size;
+}
+
+
+char *read_name(Segment *segment, ColdRecord *record) {
+    char *name = malloc(record->size + 1);
+
+    fseek(segment->file, segment->names_off + record->name_off, SEEK_SET);
+    fread(name, 1, record->size, segment->file);
+    name[record->size] = '\0';
+    return name;
+}
+
+
+/**
+ * @brief Reads the entry at a position of the name index.
+ *
+ * @return Position of the record in the segment.
+ */
+static int read_index(Segment *segment, int i) {
+    unsigned int pos;
+
+    fseek(segment->file, segment->index_off + (long) i * sizeof(unsigned int), SEEK_SET);
+    fread(&pos, sizeof(unsigned int), 1, segment->file);
+    return pos;
+}
+
+
+/**
+ * @brief Writes a record in one of the formats of export.h.
+ */
+static void print_record(FILE *out, int format, Segment *segment, ColdRecord *record) {
+    char *name = read_name(segment, record);
+
+    write_inoculation(out, format, name, record->size, record->batch, day_to_date(record->day));
+    free(name);
+}
+
+
+/**
+ * @brief Compares the name of a record with a name, reading it a chunk at a
+ * time into the stack.
+ *
+ * @return Negative, zero or positive as the name of the record sorts before,
+ * equal to or after the other.
+ */
+static int compare_name(Segment *segment, ColdRecord *record, char *name, int size) {
+    int i, step, result, common = (record->size < size) ? record->size : size;
+    char chunk[NAME_CHUNK];
+
+    fseek(segment->file, segment->names_off + record->name_off, SEEK_SET);
+    for (i = 0; i < common; i += step) {
+        step = (common - i < NAME_CHUNK) ? common - i : NAME_CHUNK;
+        fread(chunk, 1, step, segment->file);
+        if ((result = memcmp(chunk, name + i, step)) != 0) return result;
+    }
+    return record->size - size;
+}
+
+
+/**
+ * @brief Finds the first entry of the name index that belongs to a user.
+ *
+ * @return Position in the index, or segment->count if the user has no records.
+ */
+static int find_user(Segment *segment, char *name, int size) {
+    int mid, left = START, right = segment->count;
+    ColdRecord record;
+
+    while (left < right) {
+        mid = (left + right) / 2;
+        read_record(segment, read_index(segment, mid), &record);
+        if (compare_name(segment, &record, name, size) < 0) left = mid + 1;
+        else right = mid;
+    }
+    if (left < segment->count) {
+        read_record(segment, read_index(segment, left), &record);
+        if (compare_name(segment, &record, name, size) == 0) return left;
+    }
+    return segment->count;
+}
+
+
+/**
+ * @brief Collects the positions of the records of a user in a segment.
+ *
+ * The records of a user are consecutive in the name index and share the
+ * same name offset.
+ *
+ * @param positions Pointer to the array of positions, to be freed by the caller.
+ * @return Number of records of the user.
+ */
+static int user_positions(Segment *segment, User *user, int **positions) {
+    int i, count = START, first = find_user(segment, user->name, user->size);
+    ColdRecord record, start;
+
+    *positions = NULL;
+    if (first == segment->count) return 0;
+    read_record(segment, read_index(segment, first), &start);
+    *positions = malloc(sizeof(int) * (segment->count - first));
+    for (i = first; i < segment->count; i++) {
+        (*positions)[count] = read_index(segment, i);
+        read_record(segment, (*positions)[count], &record);
+        if (record.name_off != start.name_off) break;
+        count++;
+    }
+    return count;
+}
+
+
+int spill(Ino *inolink, HashTable *ht, Catalog *catalog, int cutoff) {
+    int i, j, n = START, names_size = START;
+    LinkInl ino;
+    Spilled *sorted;
+    unsigned int *offsets;
+    ColdRecord record;
+    Segment *segment, **tail;
+    User *user;
+    FILE *file = NULL;
+
+    for (ino = inolink->last; ino != NULL && date_to_day(ino->date) < cutoff; ino = ino->prev) n++;
+    if (n > 0 && (file = tmpfile()) == NULL) return 0;     /* No segment: the records stay in memory */
+    if (cutoff > inolink->cutoff) inolink->cutoff = cutoff;
+    if (n == 0) return 0;
+
+    sorted = malloc(sizeof(Spilled) * n);
+    offsets = malloc(sizeof(unsigned int) * n);     /* Name offset of each position */
+    for (i = 0, ino = inolink->last; i < n; i++, ino = ino->prev) {
+        sorted[i].ino = ino;
+        sorted[i].pos = i;
+    }
+    qsort(sorted, n, sizeof(Spilled), comp_spill);
+
+    for (i = 0; i < n; i = j) {         /* One group per user, its oldest records */
+        find_hash(ht, sorted[i].ino->name, strlen(sorted[i].ino->name), &user);
+        for (j = i; j < n && sorted[j].ino->name == sorted[i].ino->name; j++)
+            offsets[sorted[j].pos] = names_size;
+        names_size += user->size + 1;
+        user->count -= j - i;
+        user->cold += j - i;
+        memmove(user_inos(user), user_inos(user) + (j - i), sizeof(unsigned int) * user->count);
+    }
+
+    segment = malloc(sizeof(Segment));
+    segment->file = file;
+    segment->count = segment->live = n;
+    segment->index_off = (long) n * sizeof(ColdRecord);
+    segment->names_off = segment->index_off + (long) n * sizeof(unsigned int);
+    segment->deleted = calloc((n + 7) / 8, 1);
+    segment->next = NULL;
+
+    memset(&record, 0, sizeof(ColdRecord));
+    for (i = 0, ino = inolink->last; i < n; i++, ino = ino->prev) {    /* Records, in date order */
+        record.name_off = offsets[i];
+        record.size = strlen(ino->name);
+        record.day = date_to_day(ino->date);
+        record.seq = ino->seq;
+        record.vaccine = find_name(catalog, ino->vaccine->name);
+        strcpy(record.batch, ino->vaccine->batch);
+        fwrite(&record, sizeof(ColdRecord), 1, segment->file);
+    }
+    for (i = 0; i < n; i++)             /* Index sorted by user name */
+        fwrite(&sorted[i].pos, sizeof(int), 1, segment->file);
+    for (i = 0; i < n; i++) {           /* User names, once per user */
+        if (i == 0 || sorted[i].ino->name != sorted[i - 1].ino->name)
+            fwrite(sorted[i].ino->name, 1, strlen(sorted[i].ino->name) + 1, segment->file);
+    }
+
+    for (i = 0; i < n; i++)             /* The records leave memory, oldest first */
+        remove_inoculation(inolink, inolink->last);
+
+    for (tail = &inolink->segments; *tail != NULL; tail = &(*tail)->next);
+    *tail = segment;
+
+    free(sorted); free(offsets);
+    return n;
+}
+
+
+int print_cold(Ino *inolink, FILE *out, int format) {
+    int i, j, size, count = START;
+    Segment *segment;
+    ColdRecord records[COLD_CHUNK];
+
+    for (segment = inolink->segments; segment != NULL; segment = segment->next) {
+        for (i = 0; i < segment->count; i += COLD_CHUNK) {
+            size = read_records(segment, i, records);
+            for (j = 0; j < size; j++) {
+                if (!IS_DELETED(segment, i + j)) {
+                    print_record(out, format, segment, &records[j]);
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+
+void print_cold_user(Ino *inolink, User *user, FILE *out, int format) {
+    int i, count, *positions;
+    Segment *segment;
+    ColdRecord record;
+
+    if (user->cold == 0) return;
+    for (segment = inolink->segments; segment != NULL; segment = segment->next) {
+        count = user_positions(segment, user, &positions);
+        for (i = 0; i < count; i++) {
+            if (IS_DELETED(segment, positions[i])) continue;
+            read_record(segment, positions[i], &record);
+            print_record(out, format, segment, &record);
+        }
+        free(positions);
+    }
+}
+
+
+int remove_cold(Ino *inolink, User *user, int day, char *batch) {
+    int i, count, *positions, removed = START;
+    Segment *segment;
+    ColdRecord record;
+
+    if (user->cold == 0) return 0;
+    for (segment = inolink->segments; segment != NULL; segment = segment->next) {
+        count = user_positions(segment, user, &positions);
+        for (i = 0; i < count; i++) {
+            if (IS_DELETED(segment, positions[i])) continue;
+            read_record(segment, positions[i], &record);
+            if (day != ALL_DAYS && record.day != day) continue;
+            if (batch != NULL && strcmp(batch, record.batch) != 0) continue;
+            segment->deleted[positions[i] >> 3] |= 1 << (positions[i] & 7);
+            segment->live--;
+            removed++;
+        }
+        free(positions);
+    }
+    user->cold -= removed;
+    return removed;
+}
+
+
+/**
+ * @brief Finds the first record of a segment after a day and sequence number.
+ *
+ * Records are in the order of the list, by day and then by sequence number,
+ * and sequence numbers start at 1, so seq 0 finds the first record of the day.
+ */
+static int first_after(Segment *segment, int day, unsigned int seq) {
+    int mid, left = START, right = segment->count;
+    ColdRecord record;
+
+    while (left < right) {
+        mid = (left + right) / 2;
+        read_record(segment, mid, &record);
+        if (record.day < day || (record.day == day && record.seq <= seq)) left = mid + 1;
+        else right = mid;
+    }
+    return left;
+}
+
+
+int print_cold_range(Ino *inolink, int first, int end, int vaccine) {
+    int i, count = START;
+    Segment *segment;
+    ColdRecord record;
+
+    for (segment = inolink->segments; segment != NULL; segment = segment->next) {
+        for (i = first_after(segment, first, START); i < segment->count; i++) {
+            read_record(segment, i, &record);
+            if (record.day > end) break;
+            if (IS_DELETED(segment, i) || (vaccine != NO_NAME && record.vaccine != vaccine)) continue;
+            print_record(stdout, TEXT_FORMAT, segment, &record);
+            count++;
+        }
+    }
+    return count;
+}
+
+
+int print_cold_page(Ino *inolink, int *day, unsigned int *seq, int limit) {
+    int i, count = START;
+    Segment *segment;
+    ColdRecord record;
+
+    for (segment = inolink->segments; segment != NULL && count < limit; segment = segment->next) {
+        for (i = first_after(segment, *day, *seq); i < segment->count && count < limit; i++) {
+            if (IS_DELETED(segment, i)) continue;
+            read_record(segment, i, &record);
+            print_record(stdout, TEXT_FORMAT, segment, &record);
+            count++;
+            *day = record.day;
+            *seq = record.seq;
+        }
+    }
+    return count;
+}
+
+
+int more_cold(Ino *inolink, int day, unsigned int seq) {
+    int i;
+    Segment *segment;
+
+    for (segment = inolink->segments; segment != NULL; segment = segment->next) {
+        for (i = first_after(segment, day, seq); i < segment->count; i++) {
+            if (!IS_DELETED(segment, i)) return 1;
+        }
+    }
+    return 0;
+}
+
+
+int print_cold_batch(Ino *inolink, char *batch) {
+    int i, count = START;
+    Segment *segment;
+    ColdRecord record;
+
+    for (segment = inolink->segments; segment != NULL; segment = segment->next) {
+        for (i = 0; i < segment->count; i++) {
+            read_record(segment, i, &record);
+            if (IS_DELETED(segment, i) || strcmp(batch, record.batch) != 0) continue;
+            print_record(stdout, TEXT_FORMAT, segment, &record);
+            count++;
+        }
+    }
+    return count;
+}
+
+
+/**
+ * @brief Reads the name section of a segment.
+ *
+ * @return The names, to be freed by the caller.
+ */
+static char *read_names(Segment *segment) {
+    long size;
+    char *names;
+
+    fseek(segment->file, 0, SEEK_END);
+    size = ftell(segment->file) - segment->names_off;
+    names = malloc(size);
+    fseek(segment->file, segment->names_off, SEEK_SET);
+    fread(names, 1, size, segment->file);
+    return names;
+}
+
+
+/**
+ * @brief Deletes the records of the segments applied before a day.
+ *
+ * @return Number of records deleted.
+ */
+static int purge_segments(Ino *inolink, HashTable *ht, int cutoff) {
+    int i, j, size = START, count = START;
+    char *names;
+    Segment *segment, **link = &inolink->segments;
+    ColdRecord records[COLD_CHUNK];
+    User *user;
+
+    while ((segment = *link) != NULL) {
+        if (read_records(segment, START, records) == 0 || records[0].day >= cutoff) break;
+        names = read_names(segment);
+        for (i = 0; i < segment->count; i += COLD_CHUNK) {
+            size = read_records(segment, i, records);
+            for (j = 0; j < size && records[j].day < cutoff; j++) {
+                if (IS_DELETED(segment, i + j)) continue;
+                segment->deleted[(i + j) >> 3] |= 1 << ((i + j) & 7);
+                segment->live--;
+                count++;
+                find_hash(ht, names + records[j].name_off, records[j].size, &user);
+                if (--user->cold + user->count == 0) remove_user_ptr(ht, user);
+            }
+            if (j < size) break;
+        }
+        free(names);
+        if (segment->live > 0) break;   /* The next segments are more recent */
+        *link = segment->next;
+        fclose(segment->file);
+        free(segment->deleted);
+        free(segment);
+    }
+    return count;
+}
+
+
+int purge(Ino *inolink, HashTable *ht, int cutoff) {
+    int i, k, n = START, size, emptied = START;
+    unsigned int *inos;
+    LinkInl ino;
+    User *user, **empty;
+
+    for (ino = inolink->last; ino != NULL && date_to_day(ino->date) < cutoff; ino = ino->prev) n++;
+    if (n == 0) return purge_segments(inolink, ht, cutoff);
+
+    empty = malloc(sizeof(User*) * n);
+    for (i = 0, ino = inolink->last; i < n; i++, ino = ino->prev) {
+        size = strlen(ino->name);
+        find_hash(ht, ino->name, size, &user);
+        inos = user_inos(user);
+        for (k = 0; k < user->count && date_to_day(RECORD(inolink, inos[k])->date) < cutoff; k++);
+        if (k == 0) continue;       /* Its first record already cut the user */
+        user->count -= k;
+        memmove(inos, inos + k, sizeof(unsigned int) * user->count);
+        if (user->count + user->cold == 0) empty[emptied++] = user;
+    }
+    for (i = 0; i < n; i++)             /* The records leave memory, oldest first */
+        remove_inoculation(inolink, inolink->last);
+    for (i = 0; i < emptied; i++)       /* Their names were in use until now */
+        remove_user_ptr(ht, empty[i]);
+    free(empty);
+    return n + purge_segments(inolink, ht, cutoff);
+}
+
+
+void free_segments(Ino *inolink) {
+    Segment *next;
+    while (inolink->segments != NULL) {
+        next = inolink->segments->next;
+        fclose(inolink->segments->file);
+        free(inolink->segments->deleted);
+        free(inolink->segments);
+        inolink->segments = next;
+    }
+}
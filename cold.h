@@ -0,0 +1,205 @@
+/**
+ * @file cold.h
+ * @brief Header file for the cold tier of historical inoculations.
+ *
+ * Declares the on-disk segments that hold inoculations older than the
+ * retention horizon. Each segment is immutable: its records are stored in
+ * date order, followed by an index of the records sorted by user name and
+ * by the user names themselves. Deletions are kept in memory as tombstones.
+ * 
+ * To be included by modules that read or delete the whole inoculation history.
+ * 
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef COLD_H
+#define COLD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+#include "user.h"
+#include "catalog.h"
+
+#define ALL_DAYS    -1      /**< Day used to remove records of every date */
+#define COLD_CHUNK  256     /**< Records read at a time when scanning a segment */
+#define NAME_CHUNK  64      /**< Bytes of a name read at a time when comparing it */
+
+#define IS_DELETED(S, P) ((S)->deleted[(P) >> 3] & (1 << ((P) & 7)))   /**< Tests the tombstone of record P of segment S */
+
+
+/**
+ * @brief Inoculation record as stored in a segment.
+ */
+typedef struct {
+    unsigned int name_off;  /**< Offset of the user name in the name section */
+    int size;               /**< Length of the user name */
+    int day;                /**< Day number of the inoculation */
+    unsigned int seq;       /**< Sequence number it had in memory */
+    int vaccine;            /**< Id of the vaccine name in the catalog */
+    char batch[BATCH_SIZE]; /**< Batch code */
+} ColdRecord;
+
+
+/**
+ * @brief Immutable segment file with inoculations moved out of memory.
+ */
+typedef struct segment {
+    FILE *file;             /**< Segment file */
+    int count;              /**< Number of records in the segment */
+    int live;               /**< Number of records not deleted */
+    long index_off;         /**< Offset of the index sorted by user name */
+    long names_off;         /**< Offset of the user names */
+    unsigned char *deleted; /**< Tombstones, one bit per record */
+    struct segment *next;   /**< Next (more recent) segment */
+} Segment;
+
+
+/**
+ * @brief Moves every inoculation applied before a day to a new segment.
+ *
+ * The records are the oldest of the inoculation list, of each user and of
+ * each batch, so they are removed from the front of every index.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param ht Pointer to the hash table of users.
+ * @param catalog Pointer to the catalog (vaccine name ids).
+ * @param cutoff First day number that stays in memory.
+ * @return Number of records moved (none, and all stay in memory, if no
+ * temporary file can be opened).
+ */
+int spill(Ino *inolink, HashTable *ht, Catalog *catalog, int cutoff);
+
+
+/**
+ * @brief Reads the next chunk of records of a segment, in date order.
+ *
+ * @param segment Pointer to the segment.
+ * @param first Position of the first record to read.
+ * @param records Array of COLD_CHUNK records to fill.
+ * @return Number of records read.
+ */
+int read_records(Segment *segment, int first, ColdRecord records[]);
+
+
+/**
+ * @brief Reads the user name of a record.
+ *
+ * @param segment Pointer to the segment that holds the record.
+ * @param record Pointer to the record.
+ * @return Null-terminated copy of the name, to be freed by the caller.
+ */
+char *read_name(Segment *segment, ColdRecord *record);
+
+
+/**
+ * @brief Writes, in date order, every record kept in the segments.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param out Output stream.
+ * @param format Record format (see export.h).
+ * @return Number of records written.
+ */
+int print_cold(Ino *inolink, FILE *out, int format);
+
+
+/**
+ * @brief Writes, in date order, the records of a user kept in the segments.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param user Pointer to the user.
+ * @param out Output stream.
+ * @param format Record format (see export.h).
+ */
+void print_cold_user(Ino *inolink, User *user, FILE *out, int format);
+
+
+/**
+ * @brief Prints the records of the segments applied between two days.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param first First day number of the range.
+ * @param end Last day number of the range.
+ * @param vaccine Id of the vaccine name to filter by, or NO_NAME for every vaccine.
+ * @return Number of records printed.
+ */
+int print_cold_range(Ino *inolink, int first, int end, int vaccine);
+
+
+/**
+ * @brief Prints, in date order, a page of the records of the segments.
+ *
+ * Same position as print_page, kept by the records when they are spilled;
+ * each segment is entered by binary search.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param day Pointer to the day number of the position.
+ * @param seq Pointer to the sequence number of the position.
+ * @param limit Maximum number of records to print.
+ * @return Number of records printed.
+ */
+int print_cold_page(Ino *inolink, int *day, unsigned int *seq, int limit);
+
+
+/**
+ * @brief Tells whether a record of the segments follows a position.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param day Day number of the position.
+ * @param seq Sequence number of the position.
+ * @return 1 if print_cold_page would print another record from the position.
+ */
+int more_cold(Ino *inolink, int day, unsigned int seq);
+
+
+/**
+ * @brief Prints the records of the segments given from a batch.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param batch Batch code.
+ * @return Number of records printed.
+ */
+int print_cold_batch(Ino *inolink, char *batch);
+
+
+/**
+ * @brief Deletes records of a user from the segments.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param user Pointer to the user.
+ * @param day Day number of the records to delete, or ALL_DAYS.
+ * @param batch Batch code of the records to delete, or NULL for any batch.
+ * @return Number of records deleted.
+ */
+int remove_cold(Ino *inolink, User *user, int day, char *batch);
+
+
+/**
+ * @brief Deletes every inoculation applied before a day, in memory and in the segments.
+ *
+ * The records go in date order, so each user loses the first records of its
+ * array and each segment a prefix of its records; segments left empty are
+ * closed, and users left without inoculations are freed.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param ht Pointer to the hash table of users.
+ * @param cutoff First day number that is kept.
+ * @return Number of records deleted.
+ */
+int purge(Ino *inolink, HashTable *ht, int cutoff);
+
+
+/**
+ * @brief Closes and frees every segment.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ */
+void free_segments(Ino *inolink);
+
+
+#endif
@@ -0,0 +1,255 @@
+/**
+ * @file coverage.c
+ * @brief Implements the counts of distinct users vaccinated with each vaccine.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inoculation.h"
+#include "coverage.h"
+
+
+/**
+ * @brief Empties the tables, leaving the mode as it is.
+ */
+static void empty_coverage(Coverage *coverage) {
+    coverage->pairs = NULL;
+    coverage->pairs_size = START;
+    coverage->num_pairs = START;
+    coverage->users = NULL;
+    coverage->sketches = NULL;
+    coverage->daily = NULL;
+    coverage->daily_size = NULL;
+    coverage->num_ids = START;
+}
+
+
+void start_coverage(Coverage *coverage) {
+    empty_coverage(coverage);
+    coverage->precision = EXACT;
+}
+
+
+void free_coverage(Coverage *coverage) {
+    int i;
+    Pair *pair, *next;
+
+    for (i = 0; i < coverage->pairs_size; i++) {
+        for (pair = coverage->pairs[i]; pair != NULL; pair = next) {
+            next = pair->next;
+            free(pair);
+        }
+    }
+    for (i = 0; i < coverage->num_ids; i++) {
+        free(coverage->daily[i]);
+        if (coverage->sketches != NULL) free(coverage->sketches[i]);
+    }
+    free(coverage->pairs);
+    free(coverage->users);
+    free(coverage->sketches);
+    free(coverage->daily);
+    free(coverage->daily_size);
+    empty_coverage(coverage);
+}
+
+
+/**
+ * @brief Hashes a user name to 64 well-mixed bits (FNV-1a and a final mix).
+ */
+static unsigned long long hash_user(char *name, int size) {
+    int i;
+    unsigned long long h = 0xcbf29ce484222325ULL;
+
+    for (i = 0; i < size; i++) {
+        h ^= (unsigned char) name[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+
+/**
+ * @brief Makes room in the tables by vaccine name id for an id.
+ */
+static void grow_ids(Coverage *coverage, int name_id) {
+    int i, size = (coverage->num_ids == 0) ? NUM_COVER_IDS : coverage->num_ids;
+
+    while (size <= name_id) size *= 2;
+    coverage->daily = realloc(coverage->daily, sizeof(int*) * size);
+    coverage->daily_size = realloc(coverage->daily_size, sizeof(int) * size);
+    if (coverage->precision == EXACT)
+        coverage->users = realloc(coverage->users, sizeof(int) * size);
+    else coverage->sketches = realloc(coverage->sketches, sizeof(unsigned char*) * size);
+
+    for (i = coverage->num_ids; i < size; i++) {
+        coverage->daily[i] = NULL;
+        coverage->daily_size[i] = START;
+        if (coverage->precision == EXACT) coverage->users[i] = START;
+        else coverage->sketches[i] = calloc(1 << coverage->precision, 1);
+    }
+    coverage->num_ids = size;
+}
+
+
+/**
+ * @brief Doubles the table of users.
+ */
+static void grow_pairs(Coverage *coverage) {
+    int i, index, size = (coverage->pairs_size == 0) ? NUM_PAIRS : coverage->pairs_size * 2;
+    Pair **pairs = calloc(size, sizeof(Pair*)), *pair, *next;
+
+    for (i = 0; i < coverage->pairs_size; i++) {
+        for (pair = coverage->pairs[i]; pair != NULL; pair = next) {
+            next = pair->next;
+            index = (hash_user(pair->name, pair->size) + pair->name_id) % size;
+            pair->next = pairs[index];
+            pairs[index] = pair;
+        }
+    }
+    free(coverage->pairs);
+    coverage->pairs = pairs;
+    coverage->pairs_size = size;
+}
+
+
+/**
+ * @brief Finds the link that points to the pair of a user and a vaccine.
+ *
+ * @return The link, pointing to NULL if there is no such pair.
+ */
+static Pair **find_pair(Coverage *coverage, char *name, int size, int name_id) {
+    Pair **link = &coverage->pairs[(hash_user(name, size) + name_id) % coverage->pairs_size];
+
+    while (*link != NULL && ((*link)->name_id != name_id || (*link)->size != size ||
+                memcmp((*link)->name, name, size) != 0))
+        link = &(*link)->next;
+    return link;
+}
+
+
+/**
+ * @brief Adds a user to a sketch: the first bits choose the register, the
+ * position of the first 1 in the others is the value it keeps the maximum of.
+ */
+static void sketch_add(unsigned char *sketch, int precision, char *name, int size) {
+    unsigned long long h = hash_user(name, size), rest = h << precision;
+    int rank = 1;
+
+    while (rank <= 64 - precision && !(rest & 0x8000000000000000ULL)) {
+        rank++;
+        rest <<= 1;
+    }
+    if (sketch[h >> (64 - precision)] < rank) sketch[h >> (64 - precision)] = rank;
+}
+
+
+void coverage_add(Coverage *coverage, char *name, int size, int name_id, int day) {
+    int old;
+    Pair **link, *pair;
+
+    if (name_id >= coverage->num_ids) grow_ids(coverage, name_id);
+    if (day >= coverage->daily_size[name_id]) {
+        old = coverage->daily_size[name_id];
+        coverage->daily_size[name_id] = (old == 0) ? NUM_COVER_DAYS : old;
+        while (day >= coverage->daily_size[name_id]) coverage->daily_size[name_id] *= 2;
+        coverage->daily[name_id] = realloc(coverage->daily[name_id], sizeof(int) * coverage->daily_size[name_id]);
+        memset(coverage->daily[name_id] + old, 0, sizeof(int) * (coverage->daily_size[name_id] - old));
+    }
+    coverage->daily[name_id][day]++;
+
+    if (coverage->precision != EXACT) {
+        sketch_add(coverage->sketches[name_id], coverage->precision, name, size);
+        return;
+    }
+    if (coverage->num_pairs >= coverage->pairs_size * PAIRS_LOAD) grow_pairs(coverage);
+    if (*(link = find_pair(coverage, name, size, name_id)) != NULL) {
+        (*link)->count++;
+        return;
+    }
+    pair = malloc(sizeof(Pair));
+    pair->name = name;
+    pair->size = size;
+    pair->name_id = name_id;
+    pair->count = 1;
+    pair->next = NULL;
+    *link = pair;
+    coverage->num_pairs++;
+    coverage->users[name_id]++;     /* First live application of the vaccine to the user */
+}
+
+
+void coverage_remove(Coverage *coverage, char *name, int size, int name_id, int day) {
+    Pair **link, *pair;
+
+    if (name_id >= coverage->num_ids || day >= coverage->daily_size[name_id]) return;
+    coverage->daily[name_id][day]--;
+    if (coverage->precision != EXACT) return;
+
+    if (coverage->pairs_size == 0 ||
+            (pair = *(link = find_pair(coverage, name, size, name_id))) == NULL || --pair->count > 0)
+        return;
+    *link = pair->next;
+    free(pair);
+    coverage->num_pairs--;
+    coverage->users[name_id]--;
+}
+
+
+/**
+ * @brief Natural logarithm of a number of at least 1, without the math library.
+ */
+static double log_of(double x) {
+    int i, halvings = START;
+    double y, term, sum = 0;
+
+    while (x >= 2) {
+        x /= 2;
+        halvings++;
+    }
+    y = (x - 1) / (x + 1);          /* log x = 2 atanh y, with y below 1/3 */
+    for (i = 1, term = y; i < 40; i += 2, term *= y * y)
+        sum += term / i;
+    return 2 * sum + halvings * 0.69314718055994531;
+}
+
+
+int coverage_users(Coverage *coverage, int name_id, double *error) {
+    int j, zeros = START, m;
+    double sum = 0, estimate, root;
+    unsigned char *sketch;
+
+    *error = 0;
+    if (name_id >= coverage->num_ids) return 0;
+    if (coverage->precision == EXACT) return coverage->users[name_id];
+
+    m = 1 << coverage->precision;
+    sketch = coverage->sketches[name_id];
+    for (j = 0; j < m; j++) {
+        sum += 1.0 / (double) (1ULL << sketch[j]);
+        if (sketch[j] == 0) zeros++;
+    }
+    estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0)   /* Few users: counts the empty registers instead */
+        estimate = m * log_of((double) m / zeros);
+
+    root = (double) (1 << (coverage->precision / 2));
+    if (coverage->precision % 2) root *= 1.41421356237309505;
+    *error = 1.04 / root * estimate;        /* Standard error 1.04 / sqrt(m) */
+    return (int) (estimate + 0.5);
+}
+
+
+int coverage_day(Coverage *coverage, int name_id, int day) {
+    if (day < 0 || name_id >= coverage->num_ids || day >= coverage->daily_size[name_id]) return 0;
+    return coverage->daily[name_id][day];
+}
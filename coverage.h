@@ -0,0 +1,125 @@
+/**
+ * @file coverage.h
+ * @brief Header file for the counts of distinct users vaccinated with each vaccine.
+ *
+ * The history feeds every application made and every application deleted.
+ * In exact mode a table keeps how many live applications of each vaccine
+ * each user has, and a vaccine counts a user while that number is above 0.
+ * In HyperLogLog mode that table is replaced by one sketch of 2^precision
+ * one-byte registers per vaccine, whatever the number of users; a sketch
+ * cannot forget a user, so deletions are not subtracted there. Since a user
+ * cannot get the same vaccine twice on one day, the users of a day are its
+ * applications, counted exactly in both modes.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXACT           0       /**< Precision of the exact mode */
+#define MIN_PRECISION   4       /**< Smallest precision of the sketches */
+#define MAX_PRECISION   16      /**< Largest precision of the sketches */
+#define NUM_PAIRS       1024    /**< Initial number of buckets of the table of users */
+#define PAIRS_LOAD      0.7     /**< Pairs per bucket that trigger the growth of the table */
+#define NUM_COVER_IDS   16      /**< Initial size of the tables by vaccine name id */
+#define NUM_COVER_DAYS  64      /**< Initial number of days of the daily counts */
+#define COVERAGE_MODE   "*"     /**< Argument of `v` that sets the mode, never a vaccine name */
+
+
+/**
+ * @brief Live applications of a vaccine to a user.
+ */
+typedef struct pair {
+    char *name;             /**< User name, in the history arena */
+    int size;               /**< Length of the user name */
+    int name_id;            /**< Id of the vaccine name in the catalog */
+    int count;              /**< Live applications */
+    struct pair *next;      /**< Next pair of the same bucket */
+} Pair;
+
+
+/**
+ * @brief Distinct users of each vaccine, overall and per day.
+ */
+typedef struct {
+    Pair **pairs;           /**< Table of users per vaccine (exact mode) */
+    int pairs_size;         /**< Number of buckets */
+    int num_pairs;          /**< Number of pairs */
+    int *users;             /**< Distinct users, by vaccine name id (exact mode) */
+    unsigned char **sketches;   /**< Registers, by vaccine name id (HyperLogLog mode) */
+    int **daily;            /**< Live applications per day number, by vaccine name id */
+    int *daily_size;        /**< Number of days of each daily count */
+    int num_ids;            /**< Size of the tables by vaccine name id */
+    int precision;          /**< log2 of the registers of a sketch, or EXACT */
+} Coverage;
+
+
+/**
+ * @brief Initializes empty counts in exact mode.
+ *
+ * @param coverage Pointer to the counts.
+ */
+void start_coverage(Coverage *coverage);
+
+
+/**
+ * @brief Frees the counts; the mode is kept.
+ *
+ * @param coverage Pointer to the counts.
+ */
+void free_coverage(Coverage *coverage);
+
+
+/**
+ * @brief Counts an application.
+ *
+ * @param coverage Pointer to the counts.
+ * @param name User name, kept while the counts exist.
+ * @param size Length of the user name.
+ * @param name_id Id of the vaccine name.
+ * @param day Day number of the application.
+ */
+void coverage_add(Coverage *coverage, char *name, int size, int name_id, int day);
+
+
+/**
+ * @brief Discounts a deleted application.
+ *
+ * @param coverage Pointer to the counts.
+ * @param name User name.
+ * @param size Length of the user name.
+ * @param name_id Id of the vaccine name.
+ * @param day Day number of the application.
+ */
+void coverage_remove(Coverage *coverage, char *name, int size, int name_id, int day);
+
+
+/**
+ * @brief Returns the distinct users of a vaccine, exact or estimated.
+ *
+ * @param coverage Pointer to the counts.
+ * @param name_id Id of the vaccine name.
+ * @param error Set to the standard error of the estimate (0 in exact mode).
+ * @return Number of users.
+ */
+int coverage_users(Coverage *coverage, int name_id, double *error);
+
+
+/**
+ * @brief Returns the users of a vaccine on a day.
+ *
+ * @param coverage Pointer to the counts.
+ * @param name_id Id of the vaccine name.
+ * @param day Day number.
+ * @return Number of users.
+ */
+int coverage_day(Coverage *coverage, int name_id, int day);
+
+
+#endif
@@ -38,6 +38,44 @@ int read_date(char *date, Date *new_date, Date presente) {
 }
 
 
+int parse_date(char *date, Date *new_date) {
+    if (date == NULL) return NUM_INV_DATE;
+
+    if (sscanf(date, "%d-%d-%d", &new_date->day, &new_date->month, &new_date->year) != 3)
+        return NUM_INV_DATE;
+
+    if (new_date->month < FIRST_MONTH || new_date->month > LAST_MONTH || is_date(*new_date) != VALID)
+        return NUM_INV_DATE;
+    return VALID;
+}
+
+
+int date_to_day(Date date) {
+    int i, day, days_in_month[12] = DAYS_IN_MONTH;
+
+    day = (date.year - FIRST_YEAR) * DAYS_IN_YEAR;
+    for (i = 0; i < date.month - 1; i++)
+        day += days_in_month[i];
+    return day + date.day - FIRST_DAY;
+}
+
+
+Date day_to_date(int day) {
+    int days_in_month[12] = DAYS_IN_MONTH;
+    Date date;
+
+    date.year = FIRST_YEAR + day / DAYS_IN_YEAR;
+    day %= DAYS_IN_YEAR;
+    date.month = FIRST_MONTH;
+    while (day >= days_in_month[date.month - 1]) {
+        day -= days_in_month[date.month - 1];
+        date.month++;
+    }
+    date.day = day + FIRST_DAY;
+    return date;
+}
+
+
 void print_date(Date date) {
     printf("%s%d-%s%d-%d", Zero(date.day), date.day, Zero(date.month), date.month, date.year);
 }
@@ -45,8 +83,8 @@ void print_date(Date date) {
 
 int is_date(Date date) {
     int days_in_month[12] = DAYS_IN_MONTH;
-    if (FIRST_DAY <= date.day && date.day <= days_in_month[date.month - 1] &&
-    FIRST_MONTH <= date.month && date.month <= LAST_MONTH &&
+    if (FIRST_MONTH <= date.month && date.month <= LAST_MONTH &&     /* The month first: it indexes the table */
+    FIRST_DAY <= date.day && date.day <= days_in_month[date.month - 1] &&
     FIRST_YEAR <= date.year) 
         return VALID;
     return INVALID;
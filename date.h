@@ -23,6 +23,7 @@
 #define FIRST_MONTH    1      /**< First valid month in a year (January). */
 #define LAST_MONTH     12     /**< Last valid month in a year (December). */
 #define FIRST_YEAR     2025   /**< Default starting year for the system. */
+#define DAYS_IN_YEAR   365    /**< Days in a (non-leap) year. */
 
 #define Zero(A)        (A < 10 ? "0" : "")  /**< Adds leading zero to single-digit numbers for date. */
 
@@ -90,6 +91,37 @@ int is_date(Date date);
 int past_date(Date date1, Date date2);
 
 
+/**
+ * @brief Parses a date string in the format "dd-mm-yyyy" without comparing it to the present.
+ *
+ * @param data The input string containing the date.
+ * @param new_date Pointer to the Date structure to populate.
+ * @return int Returns 0 if the string holds a well-formed date, otherwise NUM_INV_DATE.
+ */
+int parse_date(char *data, Date *new_date);
+
+
+/**
+ * @brief Converts a date to its day number (days since 01-01-2025).
+ *
+ * Day numbers keep the chronological order of dates and are used as keys
+ * by the date-ordered indexes.
+ *
+ * @param date The date to convert.
+ * @return int The day number of the date.
+ */
+int date_to_day(Date date);
+
+
+/**
+ * @brief Converts a day number back to a date.
+ *
+ * @param day The day number (days since 01-01-2025).
+ * @return Date The corresponding date.
+ */
+Date day_to_date(int day);
+
+
 /**
  * @brief Advances the current system date by one day.
  *
@@ -0,0 +1,135 @@
+/**
+ * @file executor.c
+ * @brief Implements the read-ahead executor of the input commands.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inoculation.h"
+#include "system.h"
+#include "executor.h"
+
+
+void start_executor(Executor *executor) {
+    executor->window = 1;
+    executor->count = START;
+    executor->starts = NULL;
+    executor->names = NULL;
+    executor->sizes = NULL;
+    executor->hashes = NULL;
+    executor->text = NULL;
+    executor->used = START;
+    executor->size = START;
+}
+
+
+void free_executor(Executor *executor) {
+    free(executor->starts);
+    free(executor->names);
+    free(executor->sizes);
+    free(executor->hashes);
+    free(executor->text);
+    start_executor(executor);
+}
+
+
+void set_window(Executor *executor, int window) {
+    executor->window = window;
+    if (executor->text == NULL) {       /* Sized for any window, as it may change in the middle of one */
+        executor->starts = malloc(sizeof(int) * MAX_WINDOW);
+        executor->names = malloc(sizeof(int) * MAX_WINDOW);
+        executor->sizes = malloc(sizeof(int) * MAX_WINDOW);
+        executor->hashes = malloc(sizeof(int) * MAX_WINDOW);
+        executor->size = WINDOW_TEXT;
+        executor->text = malloc(WINDOW_TEXT);
+    }
+}
+
+
+/**
+ * @brief Appends a command to the text of the window.
+ */
+static void add_command(Executor *executor, char *line) {
+    int size = strlen(line) + 1;
+
+    while (executor->used + size > executor->size) {
+        executor->size *= 2;
+        executor->text = realloc(executor->text, executor->size);
+    }
+    memcpy(executor->text + executor->used, line, size);
+    executor->starts[executor->count++] = executor->used;
+    executor->used += size;
+}
+
+
+int read_window(Executor *executor, char *first, FILE *file) {
+    char line[MAXBUF];
+
+    executor->count = START;
+    executor->used = START;
+    add_command(executor, first);
+    while (executor->count < executor->window && fgets(line, MAXBUF, file) != NULL)
+        add_command(executor, line);
+    return executor->count;
+}
+
+
+/**
+ * @brief Finds the user name of an `a` or `u <user>` command without changing it.
+ *
+ * @return The name, or NULL if the command names no user.
+ */
+static char *command_user(char *line, int *size) {
+    int i = 1;
+    char *name;
+
+    if (line[0] == 'a') {
+        while (line[i] == ' ') i++;
+        name = read_username(line, &i, size);
+        return (*size > 0) ? name : NULL;
+    }
+    if (line[0] != 'u' || line[1] == '\0' || line[2] == '\0' || line[2] == '\n') return NULL;
+    name = line + 2;
+    if (*name == '"') {
+        name++;
+        *size = strcspn(name, "\"\n");
+    } else *size = strcspn(name, "\n");
+    return name;
+}
+
+
+void prefetch_window(Executor *executor, HashTable *ht) {
+    int i, size;
+    char *name;
+
+    for (i = 0; i < executor->count; i++) {
+        executor->names[i] = NO_USER_NAME;
+        if ((name = command_user(window_command(executor, i), &size)) == NULL) continue;
+        executor->names[i] = name - window_command(executor, i);
+        executor->sizes[i] = size;
+        executor->hashes[i] = hash(name, size);
+        PREFETCH(&ht->user_list[executor->hashes[i] % ht->size]);
+    }
+}
+
+
+void prepare_command(Executor *executor, HashTable *ht, int i, char *buf) {
+    int ahead = i + USER_AHEAD;
+
+    if (ahead < executor->count && executor->names[ahead] != NO_USER_NAME)    /* Its bucket is in cache by now */
+        PREFETCH(ht->user_list[executor->hashes[ahead] % ht->size]);
+
+    ht->hint = (executor->names[i] != NO_USER_NAME) ? buf + executor->names[i] : NULL;
+    ht->hint_size = executor->sizes[i];
+    ht->hint_hash = executor->hashes[i];
+}
+
+
+char *window_command(Executor *executor, int i) {
+    return executor->text + executor->starts[i];
+}
@@ -0,0 +1,125 @@
+/**
+ * @file executor.h
+ * @brief Header file for the read-ahead executor of the input commands.
+ *
+ * With a window above 1, the program reads that many commands before running
+ * any of them. The user names of the `a` and `u <user>` commands in the window
+ * are hashed first and their buckets of the user table are prefetched. While
+ * the commands run, the first user of the bucket of the command USER_AHEAD
+ * places later is prefetched, its bucket having arrived by then, and each
+ * command hands its hash to the user table instead of computing it again.
+ * The commands still run one by one in their original order,
+ * and print exactly what they would print without the window. Input is read
+ * in whole windows, so an interactive session should keep the window at 1.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "user.h"
+
+#define MAX_WINDOW  1024    /**< Largest read-ahead window */
+#define WINDOW_TEXT 4096    /**< Initial size of the text of the window */
+#define USER_AHEAD  8       /**< Commands between the prefetch of a user and its command */
+#define NO_USER_NAME -1     /**< Offset of the name of a command that names no user */
+
+#if defined(__GNUC__)
+#define PREFETCH(A) __builtin_prefetch(A)   /**< Asks for the line of an address */
+#else
+#define PREFETCH(A) ((void) (A))            /**< No prefetch outside GCC and compatible compilers */
+#endif
+
+
+/**
+ * @brief Commands read ahead and their text.
+ */
+typedef struct {
+    int window;         /**< Commands read at a time (1 runs each as it is read) */
+    int count;          /**< Commands in the window */
+    int *starts;        /**< Offset of each command in the text */
+    int *names;         /**< Offset of the user name in each command, or NO_USER_NAME */
+    int *sizes;         /**< Length of the user name of each command */
+    int *hashes;        /**< Hash of the user name of each command */
+    char *text;         /**< Commands read, each null-terminated */
+    int used;           /**< Bytes of text in use */
+    int size;           /**< Size of the text */
+} Executor;
+
+
+/**
+ * @brief Initializes an executor that runs each command as it is read.
+ *
+ * @param executor Pointer to the executor.
+ */
+void start_executor(Executor *executor);
+
+
+/**
+ * @brief Frees the executor.
+ *
+ * @param executor Pointer to the executor.
+ */
+void free_executor(Executor *executor);
+
+
+/**
+ * @brief Changes the number of commands read at a time.
+ *
+ * @param executor Pointer to the executor.
+ * @param window New window (1 to MAX_WINDOW).
+ */
+void set_window(Executor *executor, int window);
+
+
+/**
+ * @brief Fills the window with a command already read and the ones after it.
+ *
+ * @param executor Pointer to the executor.
+ * @param first The command already read.
+ * @param file Input the other commands are read from.
+ * @return Number of commands in the window.
+ */
+int read_window(Executor *executor, char *first, FILE *file);
+
+
+/**
+ * @brief Hashes the users named by the `a` and `u` commands of the window and prefetches their buckets.
+ *
+ * @param executor Pointer to the executor.
+ * @param ht Pointer to the hash table of users.
+ */
+void prefetch_window(Executor *executor, HashTable *ht);
+
+
+/**
+ * @brief Prepares a command of the window to run.
+ *
+ * Prefetches the first user of the bucket of the command USER_AHEAD places
+ * later, and gives the hash of the user of this one to the user table.
+ *
+ * @param executor Pointer to the executor.
+ * @param ht Pointer to the hash table of users.
+ * @param i Position of the command.
+ * @param buf Buffer the command was copied to, where it runs.
+ */
+void prepare_command(Executor *executor, HashTable *ht, int i, char *buf);
+
+
+/**
+ * @brief Returns a command of the window.
+ *
+ * @param executor Pointer to the executor.
+ * @param i Position of the command.
+ * @return The text of the command.
+ */
+char *window_command(Executor *executor, int i);
+
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * @file export.c
+ * @brief Implements the export of the registry to CSV or JSON Lines.
+ *
+ * Rows are written straight from the batch list, the archive, the user
+ * table, the cold segments and the inoculation list, or, ordered by user,
+ * from the external sort, whose memory is bounded.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+#include "user.h"
+#include "cold.h"
+#include "system.h"
+#include "export.h"
+#include "protocol.h"
+#include "sorter.h"
+
+
+/**
+ * @brief Writes a date as dd-mm-yyyy.
+ */
+static void write_date(FILE *out, Date date) {
+    fprintf(out, "%s%d-%s%d-%d", Zero(date.day), date.day, Zero(date.month), date.month, date.year);
+}
+
+
+/**
+ * @brief Writes a CSV field, quoted when it holds a comma, a quote or a line break.
+ */
+static void write_csv(FILE *out, char *field, int size) {
+    int i;
+    for (i = 0; i < size && strchr(",\"\r\n", field[i]) == NULL; i++);
+    if (i == size) {
+        fwrite(field, 1, size, out);
+        return;
+    }
+    putc('"', out);
+    for (i = 0; i < size; i++) {
+        if (field[i] == '"') putc('"', out);
+        putc(field[i], out);
+    }
+    putc('"', out);
+}
+
+
+/**
+ * @brief Writes a JSON string, escaping quotes, backslashes and control characters.
+ */
+static void write_json(FILE *out, char *field, int size) {
+    int i;
+    putc('"', out);
+    for (i = 0; i < size; i++) {
+        if (field[i] == '"' || field[i] == '\\') fprintf(out, "\\%c", field[i]);
+        else if ((unsigned char) field[i] < ' ') fprintf(out, "\\u%04x", field[i]);
+        else putc(field[i], out);
+    }
+    putc('"', out);
+}
+
+
+void write_inoculation(FILE *out, int format, char *name, int size, char *batch, Date date) {
+    switch (format) {
+        case CSV_FORMAT:
+            fputs("inoculation,", out);
+            write_csv(out, name, size);
+            fprintf(out, ",%s,", batch);
+            write_date(out, date);
+            putc('\n', out);
+            break;
+        case JSONL_FORMAT:
+            fputs("{\"type\":\"inoculation\",\"user\":", out);
+            write_json(out, name, size);
+            fprintf(out, ",\"batch\":\"%s\",\"date\":\"", batch);
+            write_date(out, date);
+            fputs("\"}\n", out);
+            break;
+        case BINARY_FORMAT:
+            put_number(out, 1 + 2 * TEXT_BYTES + size + strlen(batch) + DATE_BYTES, LENGTH_BYTES);
+            put_number(out, ROW_STATUS, 1);
+            put_text(out, name, size);
+            put_text(out, batch, strlen(batch));
+            put_date(out, date);
+            break;
+        default:
+            fprintf(out, "%.*s %s ", size, name, batch);
+            write_date(out, date);
+            putc('\n', out);
+            break;
+    }
+}
+
+
+int read_format(char *name) {
+    if (name == NULL) return TEXT_FORMAT;
+    if (strcmp(name, "csv") == 0) return CSV_FORMAT;
+    if (strcmp(name, "jsonl") == 0) return JSONL_FORMAT;
+    return TEXT_FORMAT;
+}
+
+
+/**
+ * @brief Writes one batch.
+ */
+static void write_batch(FILE *out, int format, Vaccine *vaccine) {
+    if (format == CSV_FORMAT) {
+        fprintf(out, "batch,%s,%s,", vaccine->name, vaccine->batch);
+        write_date(out, vaccine->date);
+        fprintf(out, ",%d,%d\n", vaccine->dose, vaccine->uses);
+    }
+    else {
+        fprintf(out, "{\"type\":\"batch\",\"vaccine\":\"%s\",\"batch\":\"%s\",\"expiry\":\"", vaccine->name, vaccine->batch);
+        write_date(out, vaccine->date);
+        fprintf(out, "\",\"doses\":%d,\"uses\":%d}\n", vaccine->dose, vaccine->uses);
+    }
+}
+
+
+void write_user(FILE *out, int format, User *user) {
+    if (format == CSV_FORMAT) {
+        fputs("user,", out);
+        write_csv(out, user->name, user->size);
+        fprintf(out, ",%d\n", user->count + user->cold);
+    }
+    else {
+        fputs("{\"type\":\"user\",\"name\":", out);
+        write_json(out, user->name, user->size);
+        fprintf(out, ",\"inoculations\":%d}\n", user->count + user->cold);
+    }
+}
+
+
+int export_registry(Sys *sys, FILE *out, int format, int order) {
+    int i, rows = START;
+    User *user;
+    LinkInl ino;
+
+    setvbuf(out, NULL, _IOFBF, EXPORT_BUFFER);
+
+    for (i = 0; i < sys->entries; i++, rows++)
+        write_batch(out, format, sys->batch_list[i]);
+    for (i = 0; i < sys->archive.count; i++, rows++)      /* Reclaimed batches still used by inoculations */
+        write_batch(out, format, sys->archive.batches[i]);
+
+    if (order == BY_USER)
+        return rows + sorted_export(sys, out, format, SORT_BUDGET);
+
+    for (i = 0; i < sys->user->size; i++) {
+        for (user = sys->user->user_list[i]; user != NULL; user = user->next, rows++)
+            write_user(out, format, user);
+    }
+    rows += print_cold(sys->inolink, out, format);
+    for (ino = sys->inolink->last; ino != NULL; ino = ino->prev, rows++)
+        write_inoculation(out, format, ino->name, strlen(ino->name), ino->vaccine->batch, ino->date);
+    return rows;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file export.h
+ * @brief Header file for the export of the registry to CSV or JSON Lines.
+ *
+ * Declares the record writers shared by the listings and the export, and the
+ * export itself, which streams batches, users and inoculations to a file
+ * through a large stdio buffer, so memory use does not grow with the
+ * registry.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+
+#define TEXT_FORMAT     0       /**< Format of the u command */
+#define CSV_FORMAT      1       /**< Comma-separated values */
+#define JSONL_FORMAT    2       /**< One JSON object per line */
+#define BINARY_FORMAT   3       /**< Row frames of the binary protocol */
+
+#define BY_DATE         0       /**< Inoculations in date order, after all the users */
+#define BY_USER         1       /**< Users in name order, each followed by its inoculations */
+
+#define EXPORT_BUFFER   (1 << 20)   /**< Size of the write buffer of an export file */
+
+#define INV_FORMAT(A) ((A == ENG) ? "invalid format" : "formato inválido") /**< Error message: unknown export format */
+
+
+struct system;
+struct user;
+
+
+/**
+ * @brief Writes one inoculation.
+ *
+ * @param out Output stream.
+ * @param format TEXT_FORMAT, CSV_FORMAT, JSONL_FORMAT or BINARY_FORMAT.
+ * @param name User name (not necessarily null-terminated).
+ * @param size Length of the name.
+ * @param batch Batch code.
+ * @param date Date of the inoculation.
+ */
+void write_inoculation(FILE *out, int format, char *name, int size, char *batch, Date date);
+
+
+/**
+ * @brief Writes one user and its number of inoculations.
+ *
+ * @param out Output stream.
+ * @param format CSV_FORMAT or JSONL_FORMAT.
+ * @param user Pointer to the user.
+ */
+void write_user(FILE *out, int format, struct user *user);
+
+
+/**
+ * @brief Reads the name of a format.
+ *
+ * @param name "csv" or "jsonl".
+ * @return The format, or TEXT_FORMAT if the name is unknown.
+ */
+int read_format(char *name);
+
+
+/**
+ * @brief Streams the whole registry to a file.
+ *
+ * Writes every batch, in the order of `l` and then the archived ones by
+ * batch code, then the users and their inoculations, ordered by date or by
+ * user. By user, the inoculations go through the external sort of sorter.h,
+ * so memory stays within SORT_BUDGET.
+ * The export runs between two commands, so it always sees a consistent
+ * registry.
+ *
+ * @param sys Pointer to the system structure.
+ * @param out Output file.
+ * @param format CSV_FORMAT or JSONL_FORMAT.
+ * @param order BY_DATE or BY_USER.
+ * @return Number of rows written.
+ */
+int export_registry(struct system *sys, FILE *out, int format, int order);
+
+
+#endif
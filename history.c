@@ -0,0 +1,535 @@
+/**
+ * @file history.c
+ * @brief Implements the versioned history behind the as-of queries.
+ *
+ * Applications are nearly always recorded on the present day, so keeping
+ * the tables ordered only moves the few historical ones from manifests.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "user.h"
+#include "catalog.h"
+#include "cold.h"
+#include "system.h"
+#include "export.h"
+#include "history.h"
+
+
+void start_history(History *history) {
+    history->num_batches = START;
+    history->batches_size = NUM_VERSIONS;
+    history->batches = malloc(sizeof(BatchVersion) * NUM_VERSIONS);
+    history->num_inos = START;
+    history->inos_size = NUM_VERSIONS;
+    history->inos = malloc(sizeof(InoVersion) * NUM_VERSIONS);
+    history->num_users = START;
+    history->users_size = NUM_HIST_USERS;
+    history->users = malloc(sizeof(HistUser*) * NUM_HIST_USERS);
+    history->buckets = calloc(NUM_HIST_USERS, sizeof(HistUser*));
+    history->free_ids = malloc(sizeof(int) * NUM_HIST_USERS);
+    history->num_free = START;
+    history->file = NULL;
+    history->first = START;
+    history->spilled = START;
+    history->cutoff = START;
+    start_coverage(&history->coverage);
+    start_series(&history->series);
+}
+
+
+void free_history(History *history) {
+    int i;
+    for (i = 0; i < history->num_batches; i++)
+        free(history->batches[i].days);
+    free(history->batches);
+    free(history->inos);
+    for (i = 0; i < history->num_users; i++) {
+        if (history->users[i] == NULL) continue;
+        free(history->users[i]->open);
+        free(history->users[i]->versions);
+        free(history->users[i]);
+    }
+    free(history->users);
+    free(history->buckets);
+    free(history->free_ids);
+    if (history->file != NULL) fclose(history->file);
+    free_coverage(&history->coverage);
+    free_series(&history->series);
+}
+
+
+void history_batch(History *history, Catalog *catalog, Vaccine *vaccine, int today) {
+    BatchVersion *version;
+
+    if (history->num_batches == history->batches_size) {
+        history->batches_size *= 2;
+        history->batches = realloc(history->batches, sizeof(BatchVersion) * history->batches_size);
+    }
+    vaccine->version = history->num_batches;
+    version = &history->batches[history->num_batches++];
+    strcpy(version->batch, vaccine->batch);
+    version->key = vaccine->key;
+    version->name_id = intern_name(catalog, vaccine->name);
+    version->date = vaccine->date;
+    version->initial = vaccine->dose + vaccine->uses;
+    version->from = today;
+    version->to = OPEN_DAY;
+    version->withdrawn = OPEN_DAY;
+    version->days = NULL;
+    version->count = START;
+    version->capacity = START;
+}
+
+
+/**
+ * @brief Finds a user in the user table.
+ *
+ * @return The user, or NULL.
+ */
+static HistUser *find_user(History *history, char *name, int size) {
+    HistUser *user = history->buckets[hash(name, size) % history->users_size];
+
+    while (user != NULL && (user->size != size || memcmp(user->name, name, size) != 0))
+        user = user->next;
+    return user;
+}
+
+
+/**
+ * @brief Doubles the user table and its buckets.
+ */
+static void grow_users(History *history) {
+    int i, index;
+    HistUser *user;
+
+    history->users_size *= 2;
+    history->users = realloc(history->users, sizeof(HistUser*) * history->users_size);
+    history->free_ids = realloc(history->free_ids, sizeof(int) * history->users_size);
+    free(history->buckets);
+    history->buckets = calloc(history->users_size, sizeof(HistUser*));
+    for (i = 0; i < history->num_users; i++) {
+        if ((user = history->users[i]) == NULL) continue;
+        index = hash(user->name, user->size) % history->users_size;
+        user->next = history->buckets[index];
+        history->buckets[index] = user;
+    }
+}
+
+
+/**
+ * @brief Adds a user to the user table, sharing the live copy of a long name.
+ */
+static HistUser *add_user(History *history, char *name, int size) {
+    int index;
+    HistUser *user = malloc(sizeof(HistUser));
+
+    if (history->num_free == 0 && history->num_users == history->users_size) grow_users(history);
+    if (size < SHORT_NAME) {    /* Its live copy is inside the User, freed with it */
+        memcpy(user->short_name, name, size);
+        user->short_name[size] = '\0';
+        user->name = user->short_name;
+    }
+    else {
+        user->name = name;      /* In the user arena, which is never freed before the history */
+    }
+    user->size = size;
+    user->open = NULL;
+    user->count = START;
+    user->capacity = START;
+    user->versions = NULL;
+    user->num_versions = START;
+    user->versions_size = START;
+    user->id = (history->num_free > 0) ? history->free_ids[--history->num_free] : history->num_users++;
+    history->users[user->id] = user;
+    index = hash(name, size) % history->users_size;
+    user->next = history->buckets[index];
+    history->buckets[index] = user;
+    return user;
+}
+
+
+/**
+ * @brief Adds a version to a list of versions of a user, after those of its day.
+ */
+static void add_key(VersionKey **keys, int *count, int *capacity, int day, unsigned int seq) {
+    int i;
+
+    if (*count == *capacity) {
+        *capacity = (*capacity == 0) ? NUM_OPEN : *capacity * 2;
+        *keys = realloc(*keys, sizeof(VersionKey) * *capacity);
+    }
+    for (i = (*count)++; i > 0 && (*keys)[i - 1].day > day; i--)
+        (*keys)[i] = (*keys)[i - 1];
+    (*keys)[i].day = day;
+    (*keys)[i].seq = seq;
+}
+
+
+void history_apply(History *history, LinkInl record, int size) {
+    int i, day = date_to_day(record->date);
+    BatchVersion *version = &history->batches[record->vaccine->version];
+    HistUser *user;
+
+    if (version->count == version->capacity) {
+        version->capacity = (version->capacity == 0) ? NUM_VERSIONS : version->capacity * 2;
+        version->days = realloc(version->days, sizeof(int) * version->capacity);
+    }
+    for (i = version->count++; i > 0 && version->days[i - 1] > day; i--)
+        version->days[i] = version->days[i - 1];
+    version->days[i] = day;
+
+    if ((user = find_user(history, record->name, size)) == NULL) user = add_user(history, record->name, size);
+    add_key(&user->open, &user->count, &user->capacity, day, record->seq);
+    add_key(&user->versions, &user->num_versions, &user->versions_size, day, record->seq);
+
+    if (history->num_inos == history->inos_size) {
+        history->inos_size *= 2;
+        history->inos = realloc(history->inos, sizeof(InoVersion) * history->inos_size);
+    }
+    for (i = history->num_inos++; i > 0 && history->inos[i - 1].day > day; i--)
+        history->inos[i] = history->inos[i - 1];    /* Last of its day, as in the inoculation list */
+    history->inos[i].user = user->id;
+    history->inos[i].version = record->vaccine->version;
+    history->inos[i].day = day;
+    history->inos[i].seq = record->seq;
+    history->inos[i].to = OPEN_DAY;
+    coverage_add(&history->coverage, user->name, size, version->name_id, day);
+    series_add(&history->series, ADMINISTERED, version->name_id, day, 1);
+}
+
+
+void history_withdraw(History *history, Vaccine *vaccine, int removed, int today) {
+    BatchVersion *version = &history->batches[vaccine->version];
+
+    if (removed) version->to = today;
+    else if (version->withdrawn == OPEN_DAY) version->withdrawn = today;
+}
+
+
+/**
+ * @brief Finds the first application in memory of a day or of a later one.
+ */
+static int first_ino(History *history, int day) {
+    int mid, left = START, right = history->num_inos;
+
+    while (left < right) {
+        mid = (left + right) / 2;
+        if (history->inos[mid].day < day) left = mid + 1;
+        else right = mid;
+    }
+    return left;
+}
+
+
+/**
+ * @brief Compares the position of a version with a day and a sequence number.
+ */
+static int comp_key(InoVersion *ino, VersionKey key) {
+    if (ino->day != key.day) return (ino->day < key.day) ? -1 : 1;
+    return (ino->seq > key.seq) - (ino->seq < key.seq);
+}
+
+
+/**
+ * @brief Reads a version of the file of old versions.
+ */
+static void read_version(History *history, int pos, InoVersion *ino) {
+    fseek(history->file, (long) pos * sizeof(InoVersion), SEEK_SET);
+    fread(ino, sizeof(InoVersion), 1, history->file);
+}
+
+
+/**
+ * @brief Writes back a version of the file of old versions.
+ */
+static void write_version(History *history, int pos, InoVersion *ino) {
+    fseek(history->file, (long) pos * sizeof(InoVersion), SEEK_SET);
+    fwrite(ino, sizeof(InoVersion), 1, history->file);
+}
+
+
+/**
+ * @brief Reads the next chunk of versions of the file of old versions.
+ *
+ * @return Number of versions read.
+ */
+static int read_versions(History *history, int first, InoVersion versions[]) {
+    int size = (history->spilled - first < VERSION_CHUNK) ? history->spilled - first : VERSION_CHUNK;
+
+    fseek(history->file, (long) first * sizeof(InoVersion), SEEK_SET);
+    fread(versions, sizeof(InoVersion), size, history->file);
+    return size;
+}
+
+
+/**
+ * @brief Finds a version by its position, in memory or in the file.
+ *
+ * @return Its position in the file, with the version read into buffer, or
+ * NO_USER_NUM if it is in memory, with the version pointed to by ino.
+ */
+static int find_version(History *history, VersionKey key, InoVersion **ino, InoVersion *buffer) {
+    int mid, left = history->first, right;
+
+    if (key.day >= history->cutoff) {
+        left = START;
+        for (right = history->num_inos; left < right; ) {
+            mid = (left + right) / 2;
+            if (comp_key(&history->inos[mid], key) < 0) left = mid + 1;
+            else right = mid;
+        }
+        *ino = &history->inos[left];
+        return NO_USER_NUM;
+    }
+    for (right = history->spilled; left < right; ) {
+        mid = (left + right) / 2;
+        read_version(history, mid, buffer);
+        if (comp_key(buffer, key) < 0) left = mid + 1;
+        else right = mid;
+    }
+    read_version(history, left, buffer);
+    *ino = buffer;
+    return left;
+}
+
+
+/**
+ * @brief Discounts a closed application from the coverage counts.
+ */
+static void close_coverage(History *history, InoVersion *ino) {
+    HistUser *user = history->users[ino->user];
+    coverage_remove(&history->coverage, user->name, user->size, history->batches[ino->version].name_id, ino->day);
+}
+
+
+void history_delete(History *history, char *name, int size, int day, char *batch, int today) {
+    int i, pos, kept = START;
+    HistUser *user = find_user(history, name, size);
+    InoVersion *ino, buffer;
+
+    if (user == NULL) return;
+    for (i = 0; i < user->count; i++) {     /* Only the open versions of the user */
+        if (day == ALL_DAYS || user->open[i].day == day) {
+            pos = find_version(history, user->open[i], &ino, &buffer);
+            if (batch == NULL || strcmp(batch, history->batches[ino->version].batch) == 0) {
+                ino->to = today;
+                close_coverage(history, ino);
+                series_add(&history->series, ADMINISTERED, history->batches[ino->version].name_id, ino->day, -1);
+                if (pos != NO_USER_NUM) write_version(history, pos, ino);
+                continue;
+            }
+        }
+        user->open[kept++] = user->open[i];
+    }
+    user->count = kept;
+}
+
+
+void history_spill(History *history, int cutoff) {
+    int n = first_ino(history, cutoff);
+
+    if (n > 0) {
+        if (history->file == NULL && (history->file = tmpfile()) == NULL) return;
+        fseek(history->file, (long) history->spilled * sizeof(InoVersion), SEEK_SET);
+        fwrite(history->inos, sizeof(InoVersion), n, history->file);
+        history->spilled += n;
+        history->num_inos -= n;
+        memmove(history->inos, history->inos + n, sizeof(InoVersion) * history->num_inos);
+    }
+    if (cutoff > history->cutoff) history->cutoff = cutoff;
+}
+
+
+/**
+ * @brief Removes a user left without versions, with its name.
+ */
+static void remove_hist_user(History *history, HistUser *user) {
+    HistUser **link = &history->buckets[hash(user->name, user->size) % history->users_size];
+
+    while (*link != user) link = &(*link)->next;
+    *link = user->next;
+    history->users[user->id] = NULL;
+    history->free_ids[history->num_free++] = user->id;
+    free(user->open);
+    free(user->versions);
+    free(user);
+}
+
+
+/**
+ * @brief Drops the versions of a list made before a day.
+ */
+static void drop_keys(VersionKey *keys, int *count, int cutoff) {
+    int i;
+
+    for (i = 0; i < *count && keys[i].day < cutoff; i++);
+    *count -= i;
+    memmove(keys, keys + i, sizeof(VersionKey) * *count);
+}
+
+
+/**
+ * @brief Removes a version made before a purge from the counts and from its user.
+ */
+static void purge_version(History *history, InoVersion *ino, int cutoff) {
+    HistUser *user = history->users[ino->user];
+
+    if (ino->to == OPEN_DAY) {
+        close_coverage(history, ino);
+        if (user->count > 0 && user->open[0].day < cutoff)     /* Drops all its open versions before the cutoff */
+            drop_keys(user->open, &user->count, cutoff);
+    }
+    if (user->num_versions > 0 && user->versions[0].day < cutoff)
+        drop_keys(user->versions, &user->num_versions, cutoff);
+}
+
+
+void history_purge(History *history, int cutoff) {
+    int i, j, size, n;
+    InoVersion versions[VERSION_CHUNK];
+
+    for (i = history->first; i < history->spilled; i += size) {
+        size = read_versions(history, i, versions);
+        for (j = 0; j < size && versions[j].day < cutoff; j++)
+            purge_version(history, &versions[j], cutoff);
+        history->first = i + j;
+        if (j < size) break;
+    }
+    if (history->first == history->spilled)     /* Nothing left in the file: it is written again from the start */
+        history->first = history->spilled = START;
+
+    n = first_ino(history, cutoff);
+    for (i = 0; i < n; i++)
+        purge_version(history, &history->inos[i], cutoff);
+    history->num_inos -= n;
+    memmove(history->inos, history->inos + n, sizeof(InoVersion) * history->num_inos);
+
+    for (i = 0; i < history->num_users; i++) {      /* Users left without versions */
+        if (history->users[i] != NULL && history->users[i]->num_versions == 0)
+            remove_hist_user(history, history->users[i]);
+    }
+}
+
+
+/**
+ * @brief Counts an open version in the coverage counts.
+ */
+static void open_coverage(History *history, InoVersion *ino) {
+    HistUser *user = history->users[ino->user];
+    if (ino->to == OPEN_DAY)
+        coverage_add(&history->coverage, user->name, user->size, history->batches[ino->version].name_id, ino->day);
+}
+
+
+void history_coverage(History *history, int precision) {
+    int i, j, size;
+    InoVersion versions[VERSION_CHUNK];
+
+    free_coverage(&history->coverage);
+    history->coverage.precision = precision;
+    for (i = history->first; i < history->spilled; i += size) {
+        size = read_versions(history, i, versions);
+        for (j = 0; j < size; j++)
+            open_coverage(history, &versions[j]);
+    }
+    for (i = 0; i < history->num_inos; i++)
+        open_coverage(history, &history->inos[i]);
+}
+
+
+/**
+ * @brief Compares two batch versions in the order of `l`.
+ */
+static int comp_version(const void *a, const void *b) {
+    BatchVersion *version1 = *(BatchVersion* const*) a, *version2 = *(BatchVersion* const*) b;
+
+    if (past_date(version1->date, version2->date) == VALID)
+        return compare_batch(&version1->key, version1->batch, &version2->key, version2->batch);
+    return past_date(version1->date, version2->date);
+}
+
+
+/**
+ * @brief Counts the applications of a batch version up to a day.
+ */
+static int uses_at(BatchVersion *version, int day) {
+    int mid, left = START, right = version->count;
+
+    while (left < right) {
+        mid = (left + right) / 2;
+        if (version->days[mid] <= day) left = mid + 1;
+        else right = mid;
+    }
+    return left;
+}
+
+
+void print_batches_at(History *history, Catalog *catalog, int day) {
+    int i, count = START, uses;
+    BatchVersion **list = malloc(sizeof(BatchVersion*) * (history->num_batches + 1));
+    BatchVersion *version;
+
+    for (i = 0; i < history->num_batches; i++) {
+        if (history->batches[i].from <= day && day < history->batches[i].to)
+            list[count++] = &history->batches[i];
+    }
+    qsort(list, count, sizeof(BatchVersion*), comp_version);
+
+    for (i = 0; i < count; i++) {
+        version = list[i];
+        uses = uses_at(version, day);
+        printf("%s %s %s%d-%s%d-%d %d %d\n", catalog->names[version->name_id], version->batch,
+                Zero(version->date.day), version->date.day, Zero(version->date.month), version->date.month,
+                version->date.year, (version->withdrawn <= day) ? 0 : version->initial - uses, uses);
+    }
+    free(list);
+}
+
+
+/**
+ * @brief Prints a version if it existed at the end of a day.
+ *
+ * @return 1 if it was printed.
+ */
+static int print_version(History *history, InoVersion *ino, int day) {
+    HistUser *owner = history->users[ino->user];
+
+    if (ino->to <= day) return 0;
+    write_inoculation(stdout, TEXT_FORMAT, owner->name, owner->size,
+            history->batches[ino->version].batch, day_to_date(ino->day));
+    return 1;
+}
+
+
+int print_inoculations_at(History *history, char *name, int size, int day) {
+    int i, j, chunk, count = START;
+    HistUser *user;
+    InoVersion versions[VERSION_CHUNK], *ino;
+
+    if (name != NULL) {     /* Only the versions of the user, each found by its position */
+        if ((user = find_user(history, name, size)) == NULL) return 0;
+        for (i = 0; i < user->num_versions && user->versions[i].day <= day; i++) {
+            find_version(history, user->versions[i], &ino, versions);
+            count += print_version(history, ino, day);
+        }
+        return count;
+    }
+    for (i = history->first; i < history->spilled; i += chunk) {     /* The file, then memory: all in the order of `u` */
+        chunk = read_versions(history, i, versions);
+        for (j = 0; j < chunk; j++) {
+            if (versions[j].day > day) return count;
+            count += print_version(history, &versions[j], day);
+        }
+    }
+    for (i = 0; i < history->num_inos && history->inos[i].day <= day; i++)
+        count += print_version(history, &history->inos[i], day);
+    return count;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file history.h
+ * @brief Header file for the versioned history behind the as-of queries.
+ *
+ * Every batch and every application is kept as a version with the day it
+ * started to exist and the day it stopped (OPEN_DAY while it still exists),
+ * so `r` and `d` close a version instead of losing it. A batch version also
+ * keeps the days of its applications in order, from which its doses and uses
+ * on any past day follow without storing a copy of the state per day.
+ *
+ * Application versions name their user by an index into a table of users,
+ * which shares the live copy of long names and keeps its own only of short
+ * ones, and which lists the versions of each user, all of them for `h` and
+ * the open ones for `d`, so both reach them directly. Versions older than
+ * the retention horizon leave memory with the cold tier, to a file of the
+ * same records in the same order.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "user.h"
+#include "catalog.h"
+#include "coverage.h"
+#include "series.h"
+
+#define OPEN_DAY        0x7FFFFFFF  /**< End day of a version that still exists */
+#define NUM_VERSIONS    64          /**< Initial size of the version tables */
+#define NUM_HIST_USERS  64          /**< Initial size of the user table and of its buckets */
+#define NUM_OPEN        4           /**< Initial size of the lists of versions of a user */
+#define VERSION_CHUNK   256         /**< Versions read at a time when scanning the file of old versions */
+
+
+/**
+ * @brief Version of a batch.
+ */
+typedef struct {
+    char batch[BATCH_SIZE];     /**< Batch code */
+    BatchKey key;               /**< Packed key of the batch code */
+    int name_id;                /**< Id of the vaccine name in the catalog */
+    Date date;                  /**< Expiration date */
+    int initial;                /**< Doses when it was created, counting earlier uses */
+    int from;                   /**< Day it was created */
+    int to;                     /**< Day it was removed, or OPEN_DAY */
+    int withdrawn;              /**< Day its doses were made unavailable, or OPEN_DAY */
+    int *days;                  /**< Days of its applications, in order */
+    int count;                  /**< Number of applications */
+    int capacity;               /**< Size of the table of days */
+} BatchVersion;
+
+
+/**
+ * @brief Version of an application, as kept in memory and in the file of old versions.
+ */
+typedef struct {
+    int user;                   /**< Index of its user in the user table */
+    int version;                /**< Batch version it came from */
+    int day;                    /**< Day it was applied */
+    unsigned int seq;           /**< Sequence number of its record, orders the versions of a day */
+    int to;                     /**< Day it was deleted, or OPEN_DAY */
+} InoVersion;
+
+
+/**
+ * @brief Position of an application version, by day and sequence number.
+ */
+typedef struct {
+    int day;                    /**< Day it was applied */
+    unsigned int seq;           /**< Sequence number of its record */
+} VersionKey;
+
+
+/**
+ * @brief User that has application versions.
+ */
+typedef struct hist_user {
+    char *name;                 /**< User name (the live copy in the user arena, or short_name) */
+    int size;                   /**< Length of the user name */
+    char short_name[SHORT_NAME];    /**< Copy of a short name, whose live copy goes with its User */
+    int id;                     /**< Its index in the user table */
+    VersionKey *versions;       /**< Its versions, open or closed, in memory or in the file, in the order of `u` */
+    int num_versions;           /**< Number of its versions */
+    int versions_size;          /**< Size of the list of its versions */
+    VersionKey *open;           /**< Its open versions, in the order of `u` */
+    int count;                  /**< Number of open versions */
+    int capacity;               /**< Size of the list of open versions */
+    struct hist_user *next;     /**< Next user of the same bucket */
+} HistUser;
+
+
+/**
+ * @brief Every version, applications ordered by day and then by arrival.
+ */
+typedef struct {
+    BatchVersion *batches;      /**< Batch versions, by creation */
+    int num_batches;            /**< Number of batch versions */
+    int batches_size;           /**< Size of the table of batch versions */
+    InoVersion *inos;           /**< Application versions in memory, in the order of `u` */
+    int num_inos;               /**< Number of application versions in memory */
+    int inos_size;              /**< Size of the table of application versions */
+    HistUser **users;           /**< Users, by index (NULL once removed by a purge) */
+    int num_users;              /**< Number of indexes taken */
+    int *free_ids;              /**< Indexes of the users removed, to be taken again */
+    int num_free;               /**< Number of indexes in free_ids */
+    int users_size;             /**< Size of the user table and of its buckets */
+    HistUser **buckets;         /**< Users, by hash of their name */
+    FILE *file;                 /**< Application versions older than cutoff, in the order of `u`, or NULL */
+    int first;                  /**< Position of the first version of the file not purged */
+    int spilled;                /**< Number of versions written to the file */
+    int cutoff;                 /**< First day whose versions are in memory */
+    Coverage coverage;          /**< Distinct users of each vaccine */
+    Series series;              /**< Doses administered and expired per day and vaccine */
+} History;
+
+
+/**
+ * @brief Initializes an empty history.
+ *
+ * @param history Pointer to the history.
+ */
+void start_history(History *history);
+
+
+/**
+ * @brief Frees the history.
+ *
+ * @param history Pointer to the history.
+ */
+void free_history(History *history);
+
+
+/**
+ * @brief Opens the version of a new batch and links the batch to it.
+ *
+ * @param history Pointer to the history.
+ * @param catalog Pointer to the catalog, where the vaccine name is interned.
+ * @param vaccine The batch; its doses and uses are those it starts with.
+ * @param today Current day number.
+ */
+void history_batch(History *history, Catalog *catalog, Vaccine *vaccine, int today);
+
+
+/**
+ * @brief Records an application.
+ *
+ * @param history Pointer to the history.
+ * @param record The inoculation, already added to its user and to the inoculation list.
+ * @param size Length of the user name.
+ */
+void history_apply(History *history, LinkInl record, int size);
+
+
+/**
+ * @brief Records that a batch was removed, or that its doses were withdrawn.
+ *
+ * @param history Pointer to the history.
+ * @param vaccine The batch.
+ * @param removed Non-zero if the batch left the batch list.
+ * @param today Current day number.
+ */
+void history_withdraw(History *history, Vaccine *vaccine, int removed, int today);
+
+
+/**
+ * @brief Closes the versions of the applications deleted by a `d` command.
+ *
+ * @param history Pointer to the history.
+ * @param name User name.
+ * @param size Length of the user name.
+ * @param day Day of the deleted applications, or ALL_DAYS.
+ * @param batch Batch code of the deleted applications, or NULL for any.
+ * @param today Current day number.
+ */
+void history_delete(History *history, char *name, int size, int day, char *batch, int today);
+
+
+/**
+ * @brief Moves the application versions made before a day to the file of old versions.
+ *
+ * Called with the cutoff of the cold tier, before which no application can
+ * be added. If no temporary file can be opened the versions stay in memory.
+ *
+ * @param history Pointer to the history.
+ * @param cutoff First day number that stays in memory.
+ */
+void history_spill(History *history, int cutoff);
+
+
+/**
+ * @brief Removes the versions of the applications made before a day, open or closed.
+ *
+ * They are the first versions in memory and in the file, so the purge walks
+ * only them; users left without versions are removed with their names. As-of
+ * queries no longer see the applications made before the day.
+ *
+ * @param history Pointer to the history.
+ * @param cutoff First day number that is kept.
+ */
+void history_purge(History *history, int cutoff);
+
+
+/**
+ * @brief Changes the mode of the coverage counts and recounts the live applications.
+ *
+ * @param history Pointer to the history.
+ * @param precision log2 of the registers of a sketch, or EXACT.
+ */
+void history_coverage(History *history, int precision);
+
+
+/**
+ * @brief Prints the batches as `l` would have printed them at the end of a day.
+ *
+ * @param history Pointer to the history.
+ * @param catalog Pointer to the catalog, for the vaccine names.
+ * @param day The day.
+ */
+void print_batches_at(History *history, Catalog *catalog, int day);
+
+
+/**
+ * @brief Prints the applications as `u` would have printed them at the end of a day.
+ *
+ * For one user, only the versions listed for that user are looked up.
+ *
+ * @param history Pointer to the history.
+ * @param name User name, or NULL for every user.
+ * @param size Length of the user name.
+ * @param day The day.
+ * @return Number of applications printed.
+ */
+int print_inoculations_at(History *history, char *name, int size, int day);
+
+
+#endif
@@ -17,42 +17,133 @@
 #include "date.h"
 #include "vaccine.h"
 #include "inoculation.h"
+#include "catalog.h"
 
 
 
-void read_username(char *segment, char **name, int *i) {
-    int div, j = START;
+char *read_username(char *segment, int *i, int *size) {
+    int div;
+    char *name;
 
     div = (segment[*i] == '"') ? '"' : ' '; 
     *i = (segment[*i] == '"') ? *i + 1 : *i;
 
-    while(segment[*i] != div) {
-        (*name)[j++] = segment[(*i)++];
-        if (*i % 200 == 0) {
-            *name = realloc(*name, sizeof(char) * (*i * 2));
-        }
+    name = &segment[*i];
+    while(segment[*i] != div && segment[*i] != '\0') (*i)++;
+    *size = &segment[*i] - name;
+    if (div == '"' && segment[*i] == '"') (*i)++;
+    return name;
+}
+
+
+/**
+ * @brief Returns the day bucket of a day number, growing the date index if needed.
+ *
+ * @param inolink Pointer to the inoculation list structure.
+ * @param day Day number of the bucket.
+ * @return Pointer to the bucket.
+ */
+static DayBucket *day_bucket(Ino *inolink, int day) {
+    int size = inolink->num_days;
+
+    if (day >= size) {
+        while (day >= size) size *= 2;
+        inolink->days = realloc(inolink->days, sizeof(DayBucket) * size);
+        memset(inolink->days + inolink->num_days, 0, sizeof(DayBucket) * (size - inolink->num_days));
+        inolink->num_days = size;
     }
-    *name = realloc(*name, sizeof(char) * (*i + 1)),
-    (*name)[j] = '\0';
-    if (div == '"')(*i)++;
+    return &inolink->days[day];
+}
+
+
+/**
+ * @brief Finds the first entry of a day after a sequence number.
+ *
+ * @param bucket Pointer to the bucket of the day.
+ * @param seq Sequence number.
+ * @return Index of the entry, or the number of entries if none follows.
+ */
+static int entry_after(DayBucket *bucket, unsigned int seq) {
+    int mid, left = START, right = bucket->count;
+
+    while (left < right) {
+        mid = (left + right) / 2;
+        if (bucket->entries[mid].seq <= seq) left = mid + 1;
+        else right = mid;
+    }
+    return left;
 }
 
 
 void add_inoculation(Ino *inolink, LinkInl ino) {
+    int day = date_to_day(ino->date), older_day;
+    DayBucket *bucket = day_bucket(inolink, day);
+    LinkInl older, batch_older;
+
+    ino->seq = ++inolink->seq;
     ino->vaccine->dose--;
     ino->vaccine->uses++;
 
-    ino->next = inolink->head;
-    ino->prev = NULL;
-    if (inolink->head != NULL) {
-        (inolink->head)->prev = ino;
+    batch_older = ino->vaccine->last_ino;   /* Reverse index of the batch, kept in date order */
+    while (batch_older != NULL && past_date(batch_older->date, ino->date) > 0)
+        batch_older = batch_older->batch_prev;
+    ino->batch_prev = batch_older;
+    ino->batch_next = (batch_older != NULL) ? batch_older->batch_next : ino->vaccine->first_ino;
+    if (ino->batch_next != NULL) ino->batch_next->batch_prev = ino;
+    else ino->vaccine->last_ino = ino;
+    if (batch_older != NULL) batch_older->batch_next = ino;
+    else ino->vaccine->first_ino = ino;
+
+    if (inolink->head == NULL || date_to_day(inolink->head->date) <= day) {
+        older = inolink->head;      /* Usual case, the new one is the newest of the list */
+    }
+    else {                          /* Historical inoculation, goes after the newest one of an earlier day */
+        for (older_day = day; older_day >= 0 && inolink->days[older_day].newest == NULL; older_day--);
+        older = (older_day >= 0) ? inolink->days[older_day].newest : NULL;
+    }
+
+    bucket->newest = ino;           /* It is always the newest of its day */
+    if (bucket->oldest == NULL) bucket->oldest = ino;
+    if (bucket->count == bucket->capacity) {
+        bucket->capacity = (bucket->capacity == 0) ? NUM_ENTRIES : bucket->capacity * 2;
+        bucket->entries = realloc(bucket->entries, sizeof(DayEntry) * bucket->capacity);
     }
-    if (inolink->head == NULL) inolink->last = ino;
+    bucket->entries[bucket->count].seq = ino->seq;     /* Its sequence number is the highest of the day */
+    bucket->entries[bucket->count++].id = ino->id;
 
-    inolink->head = ino;
+    ino->next = older;
+    ino->prev = (older != NULL) ? older->prev : inolink->last;
+    if (ino->prev != NULL) ino->prev->next = ino;
+    else inolink->head = ino;
+    if (older != NULL) older->prev = ino;
+    else inolink->last = ino;
 }
 
 void remove_inoculation(Ino *inolink, LinkInl ino) {
+    int i, kept = START;
+    DayBucket *bucket = &inolink->days[date_to_day(ino->date)];
+
+    if (bucket->oldest == ino && bucket->newest == ino) {  /* Last one of that day */
+        bucket->oldest = NULL;
+        bucket->newest = NULL;
+    }
+    else if (bucket->oldest == ino) bucket->oldest = ino->prev;
+    else if (bucket->newest == ino) bucket->newest = ino->next;
+
+    bucket->entries[entry_after(bucket, ino->seq - 1)].id = NO_RECORD;
+    if (2 * ++bucket->removed > bucket->count) {      /* Drops the entries of the removed ones */
+        for (i = 0; i < bucket->count; i++) {
+            if (bucket->entries[i].id != NO_RECORD) bucket->entries[kept++] = bucket->entries[i];
+        }
+        bucket->count = kept;
+        bucket->removed = START;
+    }
+
+    if (ino->batch_prev != NULL) ino->batch_prev->batch_next = ino->batch_next;
+    else ino->vaccine->first_ino = ino->batch_next;
+    if (ino->batch_next != NULL) ino->batch_next->batch_prev = ino->batch_prev;
+    else ino->vaccine->last_ino = ino->batch_prev;
+
     if (ino->prev == NULL && ino->next == NULL) {  /*Only one ino*/
         inolink->head = NULL;
         inolink->last = NULL;
@@ -69,20 +160,43 @@ void remove_inoculation(Ino *inolink, LinkInl ino) {
         ino->prev->next = ino->next;
         ino->next->prev = ino->prev;
     }
-    free_inoculation(ino);
+    free_inoculation(inolink, ino);
 }
 
-void free_inoculation(LinkInl ino) {
-    free(ino);    /* Removes the user name after (in free_user) */
-}
+LinkInl new_record(Ino *inolink) {
+    LinkInl ino;
 
-void free_list_ino(LinkInl head) {
-    LinkInl t;
-    while (head != NULL) {
-        t = head->next;  
-        free_inoculation(head);
-        head = t;      
+    if (inolink->free != NULL) {        /* Reuses a released record */
+        ino = inolink->free;
+        inolink->free = ino->next;
+        return ino;
     }
+    if ((int) (inolink->used >> POOL_SHIFT) == inolink->num_blocks) {
+        inolink->num_blocks *= 2;
+        inolink->blocks = realloc(inolink->blocks, sizeof(LinkInl) * inolink->num_blocks);
+    }
+    if ((inolink->used & (POOL_BLOCK - 1)) == 0)
+        inolink->blocks[inolink->used >> POOL_SHIFT] = malloc(sizeof(struct inoculation) * POOL_BLOCK);
+
+    ino = RECORD(inolink, inolink->used);
+    ino->id = inolink->used++;
+    return ino;
+}
+
+void free_inoculation(Ino *inolink, LinkInl ino) {
+    ino->next = inolink->free;      /* Removes the user name after (in free_user) */
+    inolink->free = ino;
+}
+
+void free_list_ino(Ino *inolink) {
+    unsigned int i;
+    int day;
+    for (i = 0; i < inolink->used; i += POOL_BLOCK)
+        free(inolink->blocks[i >> POOL_SHIFT]);
+    free(inolink->blocks);
+    for (day = 0; day < inolink->num_days; day++)
+        free(inolink->days[day].entries);
+    free(inolink->days);
 }
 
 void print_inoculations(LinkInl last) {
@@ -94,15 +208,86 @@ void print_inoculations(LinkInl last) {
     }
 }
 
-void reorganize_array(LinkInl *ino_list, LinkInl ino, int count) {
+int print_range(Ino *inolink, int first, int end, int name_id) {
+    int day, count = START;
+    LinkInl i;
+
+    if (first < START) first = START;
+    if (end >= inolink->num_days) end = inolink->num_days - 1;
+
+    for (day = first; day <= end; day++) {
+        if (inolink->days[day].oldest == NULL) continue;
+        for (i = inolink->days[day].oldest; i != inolink->days[day].newest->prev; i = i->prev) {
+            if (name_id != NO_NAME && i->vaccine->name_id != name_id) continue;
+            printf("%s %s ", i->name, i->vaccine->batch);
+            print_date(i->date);
+            printf("\n");
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Finds the first inoculation in memory after a position.
+ *
+ * @return The inoculation, or NULL if none follows.
+ */
+static LinkInl page_start(Ino *inolink, int day, unsigned int seq) {
+    int n;
+    DayBucket *bucket;
+
+    if (day < START) day = START;
+    if (day < inolink->num_days && inolink->days[day].oldest != NULL) {
+        bucket = &inolink->days[day];
+        for (n = entry_after(bucket, seq); n < bucket->count && bucket->entries[n].id == NO_RECORD; n++);
+        if (n < bucket->count) return RECORD(inolink, bucket->entries[n].id);
+        day++;      /* The rest of the day was already listed */
+    }
+    for (; day < inolink->num_days && inolink->days[day].oldest == NULL; day++);
+    return (day < inolink->num_days) ? inolink->days[day].oldest : NULL;
+}
+
+int print_page(Ino *inolink, int *day, unsigned int *seq, int limit) {
+    int count = START;
+    LinkInl i;
+
+    for (i = page_start(inolink, *day, *seq); i != NULL && count < limit; i = i->prev) {
+        printf("%s %s ", i->name, i->vaccine->batch);
+        print_date(i->date);
+        printf("\n");
+        count++;
+        *day = date_to_day(i->date);
+        *seq = i->seq;
+    }
+    return count;
+}
+
+int more_inoculations(Ino *inolink, int day, unsigned int seq) {
+    return page_start(inolink, day, seq) != NULL;
+}
+
+int print_batch(Vaccine *vaccine) {
+    int count = START;
+    LinkInl i;
+
+    for (i = vaccine->first_ino; i != NULL; i = i->batch_next) {
+        printf("%s %s ", i->name, vaccine->batch);
+        print_date(i->date);
+        printf("\n");
+        count++;
+    }
+    return count;
+}
+
+void reorganize_array(unsigned int *ino_list, unsigned int id, int count) {
     int i = 0;
 
-    while (i < count && ino_list[i] != ino) {
+    while (i < count && ino_list[i] != id) {
         i++;
     }
     while (i < count - 1) {
         ino_list[i] = ino_list[i + 1];
         i++;
     }
-    ino_list[count - 1] = NULL;
 }
\ No newline at end of file
@@ -23,41 +23,103 @@
 #include "vaccine.h"
 
 #define START   0         /**< Starting index or default value used for counters and initializations. */
+#define NUM_DAYS 64       /**< Initial number of day buckets in the date index. */
+#define POOL_SHIFT 12     /**< log2 of the number of records in each block of the record pool. */
+#define POOL_BLOCK (1 << POOL_SHIFT)  /**< Number of records in each block of the record pool. */
+#define NUM_BLOCKS 16     /**< Initial size of the table of pool blocks. */
+#define NUM_ENTRIES 4     /**< Initial size of the sequence index of a day. */
+#define NO_RECORD 0xFFFFFFFFu   /**< Pool index left in the sequence index of a day by a removed record. */
+
+#define RECORD(A, ID) ((A)->blocks[(ID) >> POOL_SHIFT] + ((ID) & (POOL_BLOCK - 1))) /**< Record of the pool of A with index ID */
 
 /**
  * @brief Represents a single inoculation record for a user.
  */
 typedef struct inoculation {
+    unsigned int id;          /**< Index of the record in the record pool. */
+    unsigned int seq;         /**< Order in which it was added, never reused; orders the records of a day. */
     char *name;               /**< Name of the user who received the inoculation. */
     Date date;                /**< Date when the inoculation occurred. */
     Vaccine *vaccine;         /**< Pointer to the vaccine used in the inoculation. */
     struct inoculation *prev; /**< Pointer to the previous inoculation in the linked list. */
     struct inoculation *next; /**< Pointer to the next inoculation in the linked list. */
+    struct inoculation *batch_prev; /**< Previous inoculation given from the same batch. */
+    struct inoculation *batch_next; /**< Next inoculation given from the same batch. */
 } *LinkInl;
 
 
+/**
+ * @brief Entry of the sequence index of a day.
+ */
+typedef struct {
+    unsigned int seq; /**< Sequence number of the inoculation. */
+    unsigned int id;  /**< Index of the inoculation in the record pool, or NO_RECORD once it is removed. */
+} DayEntry;
+
+
+/**
+ * @brief Bucket of the date index holding the inoculations of a single day.
+ *
+ * Inoculations of the same day are contiguous in the linked list, so a bucket
+ * only needs the two ends of its run. It also indexes the run by sequence
+ * number, so a page resumes inside a day by binary search; removed records
+ * leave a NO_RECORD entry until they are half of the index.
+ */
+typedef struct {
+    LinkInl oldest; /**< First inoculation applied on that day (closest to the list tail). */
+    LinkInl newest; /**< Last inoculation applied on that day (closest to the list head). */
+    DayEntry *entries;  /**< Inoculations of that day, by sequence number. */
+    int count;      /**< Number of entries, removed ones included. */
+    int removed;    /**< Number of entries of removed inoculations. */
+    int capacity;   /**< Size of the table of entries. */
+} DayBucket;
+
+
 /**
  * @brief Stores the head and tail pointers of the linked list of inoculations.
+ *
+ * Also keeps the date index, one bucket per day number, used for date-range queries,
+ * the pool the records are allocated from, so they can be referred to by a
+ * 32-bit index, and the segments of the cold tier.
  */
 typedef struct {
-    LinkInl head; /**< Pointer to the first inoculation in the list. */
-    LinkInl last; /**< Pointer to the last inoculation in the list. */
+    LinkInl head;       /**< Pointer to the first inoculation in the list. */
+    LinkInl last;       /**< Pointer to the last inoculation in the list. */
+    DayBucket *days;    /**< Date index, indexed by day number. */
+    int num_days;       /**< Number of allocated day buckets. */
+    LinkInl *blocks;    /**< Blocks of POOL_BLOCK records. */
+    int num_blocks;     /**< Size of the table of blocks. */
+    unsigned int used;  /**< Number of records ever taken from the blocks. */
+    unsigned int seq;   /**< Sequence number of the last record added (the first one gets 1). */
+    LinkInl free;       /**< Released records, linked by their next pointer. */
+    struct segment *segments;  /**< Cold tier: segments with older records, oldest first. */
+    int horizon;        /**< Age in days after which records move to the cold tier (0 keeps everything in memory). */
+    int cutoff;         /**< First day number still held in memory, older inoculations can no longer be added. */
 } Ino;
 
 
 /**
- * @brief Reads a username from the input buffer.
+ * @brief Reads a username from the input buffer without copying it.
+ *
+ * The name ends at the first space, or at the closing quote when it starts
+ * with a quote.
  * 
  * @param buf The input string containing the username.
- * @param name Pointer to a dynamically allocated string where the username will be stored.
- * @param i Pointer to the index used for parsing the buffer.
+ * @param i Pointer to the index used for parsing the buffer (moved past the name).
+ * @param size Pointer where the length of the name is stored.
+ * @return Pointer to the first character of the name inside buf.
  */
-void read_username(char *buf, char **name, int *i);
+char *read_username(char *buf, int *i, int *size);
 
 
 /**
  * @brief Adds an inoculation record to the linked list.
  * 
+ * The list and the batch reverse index stay in date order: a record of the
+ * present goes to the head, a historical one after the newest record of its
+ * day or of the closest earlier day. Either way it is the newest of its day,
+ * so the sequence number it gets orders the records of a day.
+ *
  * @param inolink Pointer to the inoculation list structure.
  * @param ino Pointer to the inoculation to be added.
  */
@@ -74,19 +136,29 @@ void remove_inoculation(Ino *inolink, LinkInl ino);
 
 
 /**
- * @brief Frees memory associated with a inoculation.
+ * @brief Takes a record from the record pool.
  * 
+ * @param inolink Pointer to the inoculation list structure.
+ * @return Pointer to the record, with its index set.
+ */
+LinkInl new_record(Ino *inolink);
+
+
+/**
+ * @brief Returns a inoculation to the record pool.
+ * 
+ * @param inolink Pointer to the inoculation list structure.
  * @param ino Pointer to the inoculation to be freed.
  */
-void free_inoculation(LinkInl ino);
+void free_inoculation(Ino *inolink, LinkInl ino);
 
 
 /**
- * @brief Frees all inoculations in the list starting from the head.
+ * @brief Frees the record pool and the date index.
  * 
- * @param head Pointer to the first inoculation in the list.
+ * @param inolink Pointer to the inoculation list structure.
  */
-void free_list_ino(LinkInl head);
+void free_list_ino(Ino *inolink);
 
 
 /**
@@ -97,14 +169,67 @@ void free_list_ino(LinkInl head);
 void print_inoculations(LinkInl last);
 
 
+/**
+ * @brief Prints, in chronological order, the inoculations applied between two dates.
+ *
+ * Walks only the day buckets of the range, so the cost depends on the number of
+ * records inside the range and not on the size of the whole list.
+ *
+ * @param inolink Pointer to the inoculation list structure.
+ * @param first Day number of the first date of the range.
+ * @param end Day number of the last date of the range.
+ * @param name_id Id of the vaccine name to filter by, or NO_NAME for every vaccine.
+ * @return Number of inoculations printed.
+ */
+int print_range(Ino *inolink, int first, int end, int name_id);
+
+
+/**
+ * @brief Prints, in date order, a page of the inoculations kept in memory.
+ *
+ * The position is the day and sequence number of the last inoculation
+ * listed, and it is moved to the last one printed. Deleting or adding
+ * inoculations between pages does not move it. The date index finds the
+ * day and the sequence index of the day the first inoculation after the
+ * position, without walking the list.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param day Pointer to the day number of the position.
+ * @param seq Pointer to the sequence number of the position (0 before every inoculation of the day).
+ * @param limit Maximum number of inoculations to print.
+ * @return Number of inoculations printed.
+ */
+int print_page(Ino *inolink, int *day, unsigned int *seq, int limit);
+
+
+/**
+ * @brief Tells whether an inoculation kept in memory follows a position.
+ *
+ * @param inolink Pointer to the inoculation manager.
+ * @param day Day number of the position.
+ * @param seq Sequence number of the position.
+ * @return 1 if print_page would print another inoculation from the position.
+ */
+int more_inoculations(Ino *inolink, int day, unsigned int seq);
+
+
+/**
+ * @brief Prints every inoculation given from a batch, using the batch reverse index.
+ *
+ * @param vaccine Pointer to the batch.
+ * @return Number of inoculations printed.
+ */
+int print_batch(Vaccine *vaccine);
+
+
 /**
  * @brief Reorganizes the inoculation list array after an inoculation is removed.
  * 
- * @param ino_list Array of pointers to inoculation records.
- * @param ino The inoculation to be removed from the array.
+ * @param ino_list Array of record indexes.
+ * @param id Index of the inoculation to be removed from the array.
  * @param count Total number of inoculations in the array.
  */
-void reorganize_array(LinkInl *ino_list, LinkInl ino, int count);
+void reorganize_array(unsigned int *ino_list, unsigned int id, int count);
 
 
 #endif
\ No newline at end of file
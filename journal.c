@@ -0,0 +1,363 @@
+/**
+ * @file journal.c
+ * @brief Implements the replication journal.
+ *
+ * Entries are text lines that start with their kind; the user or vaccine
+ * name is always the last field, so it may hold spaces. The primary flushes
+ * each entry as it is written, and the follower only applies lines that end
+ * in a line break, so a line caught halfway through a write is read again at
+ * the next catch-up.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+#include "user.h"
+#include "catalog.h"
+#include "cold.h"
+#include "system.h"
+#include "journal.h"
+#include "board.h"
+
+
+void start_journal(Journal *journal) {
+    journal->file = NULL;
+    journal->source = NULL;
+    journal->path = NULL;
+    journal->written = START;
+    journal->applied = START;
+    journal->backlog = START;
+    journal->max_backlog = START;
+}
+
+
+void free_journal(Journal *journal) {
+    if (journal->file != NULL) fclose(journal->file);
+    if (journal->source != NULL) fclose(journal->source);
+    free(journal->path);
+}
+
+
+/**
+ * @brief Writes the kind and the date that start most entries.
+ */
+static void write_head(FILE *file, char kind, char *batch, Date date) {
+    fprintf(file, "%c %s %s%d-%s%d-%d", kind, batch, Zero(date.day), date.day, Zero(date.month), date.month, date.year);
+}
+
+
+/**
+ * @brief Ends an entry, making it visible to the follower.
+ */
+static void end_entry(Journal *journal) {
+    fflush(journal->file);
+    journal->written++;
+}
+
+
+void journal_date(Journal *journal, Date date) {
+    if (journal->file == NULL) return;
+    fprintf(journal->file, "%c %s%d-%s%d-%d\n", ENTRY_DATE, Zero(date.day), date.day, Zero(date.month), date.month, date.year);
+    end_entry(journal);
+}
+
+
+void journal_batch(Journal *journal, Vaccine *vaccine) {
+    if (journal->file == NULL) return;
+    write_head(journal->file, ENTRY_BATCH, vaccine->batch, vaccine->date);
+    fprintf(journal->file, " %d %d %s\n", vaccine->dose, vaccine->uses, vaccine->name);
+    end_entry(journal);
+}
+
+
+/**
+ * @brief Writes an inoculation entry of a given kind.
+ */
+static void write_inoculation_entry(Journal *journal, char kind, char *batch, Date date, char *name, int size) {
+    write_head(journal->file, kind, batch, date);
+    fprintf(journal->file, " %.*s\n", size, name);
+    end_entry(journal);
+}
+
+
+void journal_inoculation(Journal *journal, LinkInl ino) {
+    if (journal->file == NULL) return;
+    write_inoculation_entry(journal, ENTRY_INO, ino->vaccine->batch, ino->date, ino->name, strlen(ino->name));
+}
+
+
+void journal_withdraw(Journal *journal, char *batch) {
+    if (journal->file == NULL) return;
+    fprintf(journal->file, "%c %s\n", ENTRY_WITHDRAW, batch);
+    end_entry(journal);
+}
+
+
+void journal_archive(Journal *journal, char *batch) {
+    if (journal->file == NULL) return;
+    fprintf(journal->file, "%c %s\n", ENTRY_ARCHIVE, batch);
+    end_entry(journal);
+}
+
+
+void journal_delete(Journal *journal, int check, char *date, char *batch, char *name, int size) {
+    if (journal->file == NULL) return;
+    fprintf(journal->file, "%c %d %s %s %.*s\n", ENTRY_DELETE, check, check >= WITH_DATE ? date : NO_FIELD,
+            check == WITH_BATCH ? batch : NO_FIELD, size, name);
+    end_entry(journal);
+}
+
+
+void journal_purge(Journal *journal, Date cutoff) {
+    if (journal->file == NULL) return;
+    fprintf(journal->file, "%c %s%d-%s%d-%d\n", ENTRY_PURGE, Zero(cutoff.day), cutoff.day,
+            Zero(cutoff.month), cutoff.month, cutoff.year);
+    end_entry(journal);
+}
+
+
+/**
+ * @brief Writes the present date, the batches and every inoculation, oldest first.
+ */
+static void write_snapshot(Sys *sys) {
+    int i, j, size;
+    char *name;
+    Segment *segment;
+    ColdRecord records[COLD_CHUNK];
+    LinkInl ino;
+
+    journal_date(&sys->journal, sys->present);
+    for (i = 0; i < sys->entries; i++)
+        journal_batch(&sys->journal, sys->batch_list[i]);
+    for (i = 0; i < sys->archive.count; i++) {      /* Archived right away, so they never count as batches */
+        journal_batch(&sys->journal, sys->archive.batches[i]);
+        journal_archive(&sys->journal, sys->archive.batches[i]->batch);
+    }
+
+    for (segment = sys->inolink->segments; segment != NULL; segment = segment->next) {
+        for (i = 0; i < segment->count; i += size) {
+            size = read_records(segment, i, records);
+            for (j = 0; j < size; j++) {
+                if (IS_DELETED(segment, i + j)) continue;
+                name = read_name(segment, &records[j]);
+                write_inoculation_entry(&sys->journal, ENTRY_HISTORY, records[j].batch,
+                        day_to_date(records[j].day), name, records[j].size);
+                free(name);
+            }
+        }
+    }
+    for (ino = sys->inolink->last; ino != NULL; ino = ino->prev)
+        write_inoculation_entry(&sys->journal, ENTRY_HISTORY, ino->vaccine->batch, ino->date, ino->name, strlen(ino->name));
+}
+
+
+int open_journal(Sys *sys, char *path) {
+    FILE *file = fopen(path, "w");
+
+    if (file == NULL) return INVALID;
+    if (sys->journal.file != NULL) fclose(sys->journal.file);
+    free(sys->journal.path);
+    sys->journal.file = file;
+    sys->journal.path = strdup(path);
+    sys->journal.written = START;
+    write_snapshot(sys);
+    return VALID;
+}
+
+
+long read_ack(Journal *journal) {
+    long acked = START;
+    FILE *file;
+    char *path;
+
+    if (journal->path == NULL) return acked;
+    path = malloc(strlen(journal->path) + sizeof(ACK_SUFFIX));
+    sprintf(path, "%s%s", journal->path, ACK_SUFFIX);
+    if ((file = fopen(path, "r")) != NULL) {
+        if (fscanf(file, "%ld", &acked) != 1) acked = START;
+        fclose(file);
+    }
+    free(path);
+    return acked;
+}
+
+
+/**
+ * @brief Records the entries applied so far for the primary.
+ */
+static void write_ack(Journal *journal) {
+    FILE *file;
+    char *path = malloc(strlen(journal->path) + sizeof(ACK_SUFFIX));
+
+    sprintf(path, "%s%s", journal->path, ACK_SUFFIX);
+    if ((file = fopen(path, "w")) != NULL) {
+        fprintf(file, "%ld\n", journal->applied);
+        fclose(file);
+    }
+    free(path);
+}
+
+
+/**
+ * @brief Applies a batch entry.
+ */
+static void apply_batch(Sys *sys, char *line) {
+    int dose, uses, i, n = START;
+    char batch[BATCH_SIZE], date[DATE_SIZE];
+    Vaccine *vaccine;
+
+    if (sscanf(line, "%*c %20s %10s %d %d%n", batch, date, &dose, &uses, &n) != 4 || line[n] != ' ' ||
+            catalog_find(&sys->catalog, sys->batch_list, sys->entries, batch) != NUM_NO_BATCH ||
+            sys->entries == MAX_BRATCH)
+        return;
+    vaccine = malloc(sizeof(Vaccine));
+    strcpy(vaccine->batch, batch);
+    pack_batch(vaccine->batch, &vaccine->key);
+    parse_date(date, &vaccine->date);
+    vaccine->dose = dose;
+    vaccine->name = strdup(line + n + 1);
+    i = insert_batch(sys, vaccine);
+    vaccine->uses = uses;
+    sys->catalog.dose[i] = dose;
+    sys->history.batches[vaccine->version].initial = dose + uses;     /* Its version counts the earlier uses */
+    publish_batch(&sys->board, vaccine, i);
+}
+
+
+/**
+ * @brief Applies a snapshot inoculation of an archived batch, which keeps its counts.
+ */
+static void apply_archived(Sys *sys, Vaccine *vaccine, char *name, Date day) {
+    LinkInl record = new_record(sys->inolink);
+
+    record->date = day;
+    record->vaccine = vaccine;
+    insert_hash(sys->user, sys->inolink, record, name, strlen(name));
+    add_inoculation(sys->inolink, record);
+    history_apply(&sys->history, record, strlen(name));
+    vaccine->dose++;
+    vaccine->uses--;
+}
+
+
+/**
+ * @brief Applies an inoculation entry; a snapshot one keeps the counts of its batch.
+ */
+static void apply_inoculation(Sys *sys, char *line) {
+    int k, n = START;
+    char batch[BATCH_SIZE], date[DATE_SIZE], *name;
+    Date day;
+    LinkInl record;
+    Vaccine *archived;
+
+    if (sscanf(line, "%*c %20s %10s%n", batch, date, &n) != 2 || line[n] != ' ' ||
+            parse_date(date, &day) != VALID)
+        return;
+    name = line + n + 1;
+    if ((k = catalog_find(&sys->catalog, sys->batch_list, sys->entries, batch)) == NUM_NO_BATCH) {
+        if (line[0] == ENTRY_HISTORY && (archived = archive_find(&sys->archive, batch)) != NULL)
+            apply_archived(sys, archived, name, day);
+        return;
+    }
+    record = apply_dose(sys, k, name, strlen(name), day);
+    if (line[0] == ENTRY_HISTORY) {
+        record->vaccine->dose++;
+        record->vaccine->uses--;
+        sys->catalog.dose[k] = record->vaccine->dose;
+        publish_batch(&sys->board, record->vaccine, k);
+    }
+}
+
+
+/**
+ * @brief Applies a deletion entry.
+ */
+static void apply_delete(Sys *sys, char *line) {
+    int check, n = START;
+    char date[DATE_SIZE], batch[BATCH_SIZE], *name;
+
+    if (sscanf(line, "%*c %d %12s %20s%n", &check, date, batch, &n) != 3 || line[n] != ' ') return;
+    name = line + n + 1;
+    delete_applications(sys, name, strlen(name), date, batch, check);
+}
+
+
+/**
+ * @brief Applies one entry of the journal.
+ */
+static void apply_entry(Sys *sys, char *line) {
+    int i;
+    char batch[BATCH_SIZE];
+    Date date;
+
+    line[strcspn(line, "\n")] = '\0';
+    switch (line[0]) {
+        case ENTRY_DATE:
+            if (parse_date(line + 2, &date) != VALID) break;
+            move_date(sys, date);         /* The follower keeps its own horizon and reclamation */
+            break;
+        case ENTRY_BATCH: apply_batch(sys, line); break;
+        case ENTRY_INO:
+        case ENTRY_HISTORY: apply_inoculation(sys, line); break;
+        case ENTRY_WITHDRAW:
+            if (sscanf(line, "%*c %20s", batch) == 1 &&
+                    (i = catalog_find(&sys->catalog, sys->batch_list, sys->entries, batch)) != NUM_NO_BATCH)
+                withdraw_batch(sys, i);
+            break;
+        case ENTRY_DELETE: apply_delete(sys, line); break;
+        case ENTRY_ARCHIVE:
+            if (sscanf(line, "%*c %20s", batch) == 1 &&
+                    (i = catalog_find(&sys->catalog, sys->batch_list, sys->entries, batch)) != NUM_NO_BATCH)
+                archive_batch(sys, i);
+            break;
+        case ENTRY_PURGE:
+            if (parse_date(line + 2, &date) == VALID) purge_applications(sys, date);
+            break;
+        default: break;
+    }
+}
+
+
+void catch_up(Sys *sys) {
+    long pos, count = START;
+    char line[MAXBUF];
+    Journal *journal = &sys->journal;
+
+    pos = ftell(journal->source);
+    fseek(journal->source, pos, SEEK_SET);      /* Drops the end of file seen last time */
+    while (fgets(line, MAXBUF, journal->source) != NULL) {
+        if (strchr(line, '\n') == NULL) break;  /* Still being written */
+        apply_entry(sys, line);
+        pos = ftell(journal->source);
+        count++;
+    }
+    fseek(journal->source, pos, SEEK_SET);
+
+    journal->backlog = count;
+    if (count > journal->max_backlog) journal->max_backlog = count;
+    if (count > 0) {
+        journal->applied += count;
+        write_ack(journal);
+    }
+}
+
+
+int follow_journal(Sys *sys, char *path) {
+    FILE *source = fopen(path, "r");
+
+    if (source == NULL) return INVALID;
+    if (sys->journal.file != NULL) fclose(sys->journal.file);     /* A primary stops writing */
+    sys->journal.file = NULL;
+    sys->journal.source = source;
+    free(sys->journal.path);
+    sys->journal.path = strdup(path);
+    catch_up(sys);
+    return VALID;
+}
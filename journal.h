@@ -0,0 +1,185 @@
+/**
+ * @file journal.h
+ * @brief Header file for the replication journal.
+ *
+ * A primary instance writes every change it accepts (c, a, r, d, t, o, z and
+ * the imports of f) to an append-only journal file, one text entry per line,
+ * after a snapshot of its current state. A follower instance tails the same
+ * file: before each command it applies the complete entries written since the
+ * last one, and it rejects the commands that would change its state. The
+ * follower records how many entries it applied in a companion file, so the
+ * primary can report how far behind it is.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+
+#define ENTRY_DATE      'T'     /**< Entry: new present date */
+#define ENTRY_BATCH     'C'     /**< Entry: new batch, with its doses and uses */
+#define ENTRY_INO       'A'     /**< Entry: inoculation applied */
+#define ENTRY_HISTORY   'H'     /**< Entry: inoculation of the snapshot, already counted in its batch */
+#define ENTRY_WITHDRAW  'R'     /**< Entry: batch removed or made unavailable */
+#define ENTRY_DELETE    'D'     /**< Entry: inoculations deleted */
+#define ENTRY_PURGE     'P'     /**< Entry: inoculations before a date deleted */
+#define ENTRY_ARCHIVE   'X'     /**< Entry: expired batch moved to the archive */
+#define NO_FIELD        "-"     /**< Placeholder of an absent field */
+#define ACK_SUFFIX      ".ack"  /**< Suffix of the file with the entries applied by the follower */
+#define WRITE_COMMANDS  "cardtfjozR"  /**< Commands rejected by a follower */
+
+#define READ_ONLY(A) ((A == ENG) ? "read-only replica" : "réplica só de leitura") /**< Error message: change sent to a follower */
+
+
+/**
+ * @brief Replication state of an instance, as primary or as follower.
+ */
+typedef struct {
+    FILE *file;         /**< Journal written by the primary, or NULL */
+    FILE *source;       /**< Journal read by the follower, or NULL */
+    char *path;         /**< Path of the journal */
+    long written;       /**< Entries written by the primary */
+    long applied;       /**< Entries applied by the follower */
+    long backlog;       /**< Entries the follower was behind at its last catch-up */
+    long max_backlog;   /**< Largest backlog seen by the follower */
+} Journal;
+
+
+struct system;
+
+
+/**
+ * @brief Initializes an instance that is neither primary nor follower.
+ *
+ * @param journal Pointer to the journal.
+ */
+void start_journal(Journal *journal);
+
+
+/**
+ * @brief Closes the journal files.
+ *
+ * @param journal Pointer to the journal.
+ */
+void free_journal(Journal *journal);
+
+
+/**
+ * @brief Starts a new journal with a snapshot of the current state.
+ *
+ * The snapshot holds the present date, every batch and every inoculation,
+ * including the cold tier.
+ *
+ * @param sys Pointer to the system structure.
+ * @param path Path of the journal, created or truncated.
+ * @return VALID, or INVALID if the file cannot be created.
+ */
+int open_journal(struct system *sys, char *path);
+
+
+/**
+ * @brief Makes the instance a follower of a journal and catches up with it.
+ *
+ * @param sys Pointer to the system structure.
+ * @param path Path of the journal.
+ * @return VALID, or INVALID if the file cannot be opened.
+ */
+int follow_journal(struct system *sys, char *path);
+
+
+/**
+ * @brief Applies the complete entries written since the last catch-up.
+ *
+ * A partially written last line is left for the next catch-up.
+ *
+ * @param sys Pointer to the system structure.
+ */
+void catch_up(struct system *sys);
+
+
+/**
+ * @brief Reads the number of entries applied by the follower.
+ *
+ * @param journal Pointer to the journal of the primary.
+ * @return Entries acknowledged, 0 if none.
+ */
+long read_ack(Journal *journal);
+
+
+/**
+ * @brief Writes a change of the present date.
+ *
+ * @param journal Pointer to the journal.
+ * @param date New present date.
+ */
+void journal_date(Journal *journal, Date date);
+
+
+/**
+ * @brief Writes a new batch.
+ *
+ * @param journal Pointer to the journal.
+ * @param vaccine The batch.
+ */
+void journal_batch(Journal *journal, Vaccine *vaccine);
+
+
+/**
+ * @brief Writes an applied inoculation.
+ *
+ * @param journal Pointer to the journal.
+ * @param ino The inoculation record.
+ */
+void journal_inoculation(Journal *journal, LinkInl ino);
+
+
+/**
+ * @brief Writes the removal of a batch.
+ *
+ * @param journal Pointer to the journal.
+ * @param batch Batch code.
+ */
+void journal_withdraw(Journal *journal, char *batch);
+
+
+/**
+ * @brief Writes the move of an expired batch to the archive.
+ *
+ * @param journal Pointer to the journal.
+ * @param batch Batch code.
+ */
+void journal_archive(Journal *journal, char *batch);
+
+
+/**
+ * @brief Writes a deletion of inoculations.
+ *
+ * @param journal Pointer to the journal.
+ * @param check Removal mode, as in remove_application.
+ * @param date Date of the inoculations (used from WITH_DATE on).
+ * @param batch Batch code (used with WITH_BATCH).
+ * @param name User name.
+ * @param size Length of the user name.
+ */
+void journal_delete(Journal *journal, int check, char *date, char *batch, char *name, int size);
+
+
+/**
+ * @brief Writes a purge of the inoculations before a date.
+ *
+ * @param journal Pointer to the journal.
+ * @param cutoff First date that was kept.
+ */
+void journal_purge(Journal *journal, Date cutoff);
+
+
+#endif
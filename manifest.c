@@ -0,0 +1,289 @@
+/**
+ * @file manifest.c
+ * @brief Implements the bulk import of manifest files.
+ *
+ * The file is read into one buffer and every line is validated before any
+ * change is made. Accepted batches are appended to the batch list, which is
+ * sorted once, and the catalog is rebuilt from it. The inoculations are then
+ * applied in date order, so each one takes the oldest eligible batch of its
+ * day, as the a command would have done on that day.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+#include "user.h"
+#include "catalog.h"
+#include "system.h"
+#include "journal.h"
+#include "board.h"
+#include "manifest.h"
+
+
+/**
+ * @brief Cuts the next field of a line, removing its enclosing quotes.
+ *
+ * @param cursor Pointer to the position in the line, moved past the field.
+ * @param delim Field delimiter.
+ * @return The field, or NULL at the end of the line.
+ */
+static char *next_field(char **cursor, char delim) {
+    char *field = *cursor, *end;
+    if (field == NULL) return NULL;
+
+    if (*field == QUOTE && (end = strchr(field + 1, QUOTE)) != NULL) {
+        field++;
+        *end = '\0';
+        end = strchr(end + 1, delim);
+    }
+    else end = strchr(field, delim);
+
+    if (end != NULL) *end++ = '\0';
+    *cursor = end;
+    return field;
+}
+
+
+/**
+ * @brief Compares two batch lines by batch code and then by line number.
+ */
+static int comp_batch_line(const void *a, const void *b) {
+    const BatchLine *line1 = *(BatchLine* const*) a, *line2 = *(BatchLine* const*) b;
+    int result = compare_batch(&line1->vaccine->key, line1->vaccine->batch,
+            &line2->vaccine->key, line2->vaccine->batch);
+    return (result != 0) ? result : line1->line - line2->line;
+}
+
+
+/**
+ * @brief Compares two batches with the order of the batch list.
+ */
+static int comp_vaccine(const void *a, const void *b) {
+    return comp(*(Vaccine* const*) a, *(Vaccine* const*) b);
+}
+
+
+/**
+ * @brief Compares two inoculation lines by day and then by line number.
+ */
+static int comp_ino_line(const void *a, const void *b) {
+    const InoLine *line1 = a, *line2 = b;
+    return (line1->day != line2->day) ? line1->day - line2->day : line1->line - line2->line;
+}
+
+
+/**
+ * @brief Returns the message of an error code.
+ */
+static const char *error_message(int error, int language) {
+    switch (error) {
+        case NUM_DUP_BATCH: return DUP_BATCH(language);
+        case NUM_INV_BATCH: return INV_BATCH(language);
+        case NUM_INV_NAME: return INV_NAME(language);
+        case NUM_INV_DATE: return INV_DATE(language);
+        case NUM_INV_QNT: return INV_QTY(language);
+        case NUM_TOO_MANY: return TOO_MANY(language);
+        case NUM_NO_STOCK: return NO_STOCK(language);
+        default: return ALREADY(language);
+    }
+}
+
+
+/**
+ * @brief Validates a batch line with the parser of the c command.
+ *
+ * The delimiters become spaces, so the line reads as a c command. Duplicates
+ * are only checked against the registry here.
+ */
+static void read_batch_line(Sys *sys, BatchLine *batch, char *line, char delim) {
+    int i;
+    for (i = 0; line[i] != '\0'; i++)
+        if (line[i] == delim) line[i] = ' ';
+
+    batch->error = START;
+    batch->vaccine = malloc(sizeof(Vaccine));
+    batch->vaccine->batch[0] = '\0';
+    if (strspn(line + 1, SPACE) == strlen(line + 1)) batch->error = NUM_INV_BATCH;
+    else read_vaccine(sys->batch_list, batch->vaccine, sys->entries, &batch->error, line, sys->present);
+    if (batch->error == START && archive_find(&sys->archive, batch->vaccine->batch) != NULL) {
+        free(batch->vaccine->name);
+        batch->error = NUM_DUP_BATCH;
+    }
+}
+
+
+/**
+ * @brief Validates an inoculation line.
+ *
+ * @return VALID, INVALID if the line has no user, or NUM_INV_DATE.
+ */
+static int read_ino_line(Sys *sys, InoLine *ino, char *cursor, char delim) {
+    ino->user = next_field(&cursor, delim);
+    ino->vaccine = next_field(&cursor, delim);
+    if (ino->user == NULL || *ino->user == '\0') return INVALID;
+    if (ino->vaccine == NULL) ino->vaccine = "";
+
+    if (parse_date(next_field(&cursor, delim), &ino->date) != VALID || ino->date.year < FIRST_YEAR ||
+            past_date(ino->date, sys->present) > 0)
+        return NUM_INV_DATE;
+    ino->day = date_to_day(ino->date);
+    if (ino->day < sys->inolink->cutoff) return NUM_INV_DATE;   /* That day is already in the cold tier */
+    return VALID;
+}
+
+
+/**
+ * @brief Marks the repeated batch codes of the file and adds the accepted batches.
+ *
+ * @return Number of batches added.
+ */
+static int build_batches(Sys *sys, BatchLine *batches, int num_batches, int *errors) {
+    int i, j, added = START;
+    BatchLine **sorted = malloc(sizeof(BatchLine*) * (num_batches + 1));
+
+    for (i = 0, j = 0; i < num_batches; i++)    /* Lines whose batch code was read */
+        if (batches[i].vaccine->batch[0] != '\0') sorted[j++] = &batches[i];
+    qsort(sorted, j, sizeof(BatchLine*), comp_batch_line);
+    for (i = 1; i < j; i++) {           /* After the first accepted line of a code, the others are duplicates */
+        if (compare_batch(&sorted[i]->vaccine->key, sorted[i]->vaccine->batch,
+                    &sorted[i - 1]->vaccine->key, sorted[i - 1]->vaccine->batch) == 0 &&
+                (sorted[i - 1]->error == VALID || sorted[i - 1]->error == NUM_DUP_BATCH)) {
+            if (sorted[i]->error == VALID) free(sorted[i]->vaccine->name);
+            sorted[i]->error = NUM_DUP_BATCH;
+        }
+    }
+    free(sorted);
+
+    for (i = 0; i < num_batches; i++) {
+        if (sys->entries + added == MAX_BRATCH) {
+            if (batches[i].error == VALID) free(batches[i].vaccine->name);
+            batches[i].error = NUM_TOO_MANY;
+        }
+        if (batches[i].error != VALID) {
+            errors[batches[i].line] = batches[i].error;
+            free(batches[i].vaccine);
+            continue;
+        }
+        batches[i].vaccine->uses = START;
+        batches[i].vaccine->first_ino = NULL;
+        batches[i].vaccine->last_ino = NULL;
+        sys->batch_list[sys->entries + added++] = batches[i].vaccine;
+        journal_batch(&sys->journal, batches[i].vaccine);
+        history_batch(&sys->history, &sys->catalog, batches[i].vaccine, date_to_day(sys->present));
+    }
+
+    sys->entries += added;
+    qsort(sys->batch_list, sys->entries, sizeof(Vaccine*), comp_vaccine);
+    catalog_build(&sys->catalog, sys->batch_list, sys->entries);
+    publish_all(&sys->board, sys->batch_list, sys->entries);
+    return added;
+}
+
+
+/**
+ * @brief Applies the inoculations in date order.
+ *
+ * @return Number of inoculations applied.
+ */
+static int build_inoculations(Sys *sys, InoLine *inos, int num_inos, int *errors) {
+    int i, k, size, added = START;
+    LinkInl record;
+
+    qsort(inos, num_inos, sizeof(InoLine), comp_ino_line);
+    for (i = 0; i < num_inos; i++) {
+        size = strlen(inos[i].user);
+        k = catalog_first_eligible(&sys->catalog, sys->entries,
+                find_name(&sys->catalog, inos[i].vaccine), inos[i].day);
+        if (k == NO_ELIGIBLE) {
+            errors[inos[i].line] = NUM_NO_STOCK;
+            continue;
+        }
+        if (comp_inoculation(sys->user, sys->inolink, inos[i].date, inos[i].user, size, inos[i].vaccine) != VALID) {
+            errors[inos[i].line] = NUM_ALREADY;
+            continue;
+        }
+        record = apply_dose(sys, k, inos[i].user, size, inos[i].date);
+        journal_inoculation(&sys->journal, record);
+        added++;
+    }
+    return added;
+}
+
+
+/**
+ * @brief Reads a whole file into a growing buffer, chunk by chunk, so pipes
+ * and other files that cannot seek are read too.
+ *
+ * @return The text, null-terminated.
+ */
+static char *read_text(FILE *file, long *length) {
+    long size = READ_CHUNK, got;
+    char *text = malloc(size + 1);
+
+    *length = START;
+    while ((got = fread(text + *length, 1, size - *length, file)) > 0) {
+        *length += got;
+        if (*length == size) {
+            size *= 2;
+            text = realloc(text, size + 1);
+        }
+    }
+    text[*length] = '\0';
+    return text;
+}
+
+
+void import_manifest(Sys *sys, FILE *file) {
+    long length;
+    int i, num_lines = START, num_batches = START, num_inos = START, error;
+    int added_batches, added_inos;
+    char *text, *line, *end, delim;
+    int *errors;
+    BatchLine *batches;
+    InoLine *inos;
+
+    text = read_text(file, &length);       /* The whole file is read at once */
+
+    for (i = 0; i < length; i++)
+        if (text[i] == '\n') num_lines++;
+    num_lines++;
+    errors = calloc(num_lines + 1, sizeof(int));
+    batches = malloc(sizeof(BatchLine) * num_lines);
+    inos = malloc(sizeof(InoLine) * num_lines);
+
+    for (i = 1, line = text; line != NULL; i++, line = end) {   /* Validation pass */
+        if ((end = strchr(line, '\n')) != NULL) *end++ = '\0';
+        line[strcspn(line, "\r")] = '\0';
+        delim = (strchr(line, TSV_DELIM) != NULL) ? TSV_DELIM : CSV_DELIM;
+
+        if (line[0] == 'c' && (line[1] == delim || line[1] == '\0')) {
+            batches[num_batches].line = i;
+            read_batch_line(sys, &batches[num_batches++], line, delim);
+        }
+        else if (line[0] == 'a' && line[1] == delim) {
+            inos[num_inos].line = i;
+            error = read_ino_line(sys, &inos[num_inos], line + 2, delim);
+            if (error == VALID) num_inos++;
+            else if (error != INVALID) errors[i] = error;
+        }
+    }
+
+    added_batches = build_batches(sys, batches, num_batches, errors);
+    added_inos = build_inoculations(sys, inos, num_inos, errors);
+
+    for (i = 1; i <= num_lines; i++)
+        if (errors[i] != VALID) printf("%d: %s\n", i, error_message(errors[i], sys->language));
+    printf("%d %d\n", added_batches, added_inos);
+
+    free(errors);
+    free(batches);
+    free(inos);
+    free(text);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file manifest.h
+ * @brief Header file for the bulk import of manifest files.
+ *
+ * A manifest is a CSV or TSV file with one batch or one historical
+ * inoculation per line:
+ *
+ *     c,<batch>,<dd-mm-yyyy>,<doses>,<vaccine>
+ *     a,<user>,<vaccine>,<dd-mm-yyyy>
+ *
+ * The whole file is validated first, then the batches are sorted once and
+ * the catalog, the user table and the inoculation log are built in a single
+ * pass.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "system.h"
+
+#define TSV_DELIM   '\t'    /**< Field delimiter of TSV manifests */
+#define CSV_DELIM   ','     /**< Field delimiter of CSV manifests */
+#define QUOTE       '"'     /**< Character that may enclose a field */
+#define READ_CHUNK  65536   /**< Bytes read at a time from a manifest */
+
+/* Manifest Errors, after the ones of vaccine.h */
+#define NUM_TOO_MANY    6   /**< Error code: batch limit exceeded */
+#define NUM_NO_STOCK    7   /**< Error code: no eligible batch on the inoculation date */
+#define NUM_ALREADY     8   /**< Error code: vaccine already applied on that date */
+
+#define NO_FILE(A) ((A == ENG) ? ": no such file" : ": ficheiro inexistente") /**< Error message: file cannot be opened */
+
+
+/**
+ * @brief Batch line of a manifest.
+ */
+typedef struct {
+    int line;           /**< Line number in the file */
+    int error;          /**< Error code, 0 if the batch is accepted */
+    Vaccine *vaccine;   /**< Batch read from the line */
+} BatchLine;
+
+
+/**
+ * @brief Inoculation line of a manifest.
+ */
+typedef struct {
+    int line;           /**< Line number in the file */
+    int day;            /**< Day number of the inoculation */
+    Date date;          /**< Date of the inoculation */
+    char *user;         /**< User name, inside the file buffer */
+    char *vaccine;      /**< Vaccine name, inside the file buffer */
+} InoLine;
+
+
+/**
+ * @brief Imports every batch and inoculation of a manifest.
+ *
+ * Prints one "<line>: <message>" per rejected line, in line order, with the
+ * messages of the c and a commands, followed by the number of batches and of
+ * inoculations imported.
+ *
+ * @param sys Pointer to the system structure.
+ * @param file Open manifest file.
+ */
+void import_manifest(Sys *sys, FILE *file);
+
+
+#endif
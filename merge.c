@@ -0,0 +1,104 @@
+/**
+ * @file merge.c
+ * @brief Implements the merge of several command feeds by date.
+ *
+ * Only one line per feed is held at a time: a feed is read when it is at the
+ * top of the heap, and a marker for a later day puts it back in the heap
+ * until every feed on earlier days has been handed out.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "system.h"
+#include "merge.h"
+
+
+/**
+ * @brief Tells whether a feed goes before another one.
+ */
+static int feed_before(Feed *feeds, int a, int b) {
+    if (feeds[a].day != feeds[b].day) return feeds[a].day < feeds[b].day;
+    return a < b;
+}
+
+
+/**
+ * @brief Restores the heap order from the top down.
+ */
+static void sift_down(Merge *merge) {
+    int child, i = START;
+    while ((child = 2 * i + 1) < merge->count) {
+        if (child + 1 < merge->count && feed_before(merge->feeds, merge->heap[child + 1], merge->heap[child])) child++;
+        if (!feed_before(merge->feeds, merge->heap[child], merge->heap[i])) break;
+        exch(&merge->heap[i], &merge->heap[child]);
+        i = child;
+    }
+}
+
+
+/**
+ * @brief Reads the marker date of a `t` line that moves a feed forward.
+ *
+ * @return VALID, or INVALID if the line is not such a marker.
+ */
+static int read_marker(Feed *feed, Date *date) {
+    char token[DATE_SIZE];
+
+    if (feed->line[0] != 't' || sscanf(feed->line + 1, "%12s", token) != 1) return INVALID;
+    return read_date(token, date, feed->date) == VALID ? VALID : INVALID;
+}
+
+
+void start_merge(Merge *merge, FILE *files[], int count, Date present) {
+    int i;
+
+    merge->feeds = malloc(sizeof(Feed) * count);
+    merge->heap = malloc(sizeof(int) * count);
+    merge->count = count;
+    for (i = 0; i < count; i++) {      /* Same day for every feed, so the heap is in index order */
+        merge->feeds[i].file = files[i];
+        merge->feeds[i].date = present;
+        merge->feeds[i].day = date_to_day(present);
+        merge->feeds[i].pending = 0;
+        merge->heap[i] = i;
+    }
+}
+
+
+char *next_merged(Merge *merge) {
+    Feed *feed;
+    Date date;
+
+    while (merge->count > 0) {
+        feed = &merge->feeds[merge->heap[0]];
+        if (feed->pending) {            /* Its day came, the marker goes out first */
+            feed->pending = 0;
+            return feed->line;
+        }
+        if (fgets(feed->line, MAXBUF, feed->file) == NULL) {
+            merge->heap[0] = merge->heap[--merge->count];
+            sift_down(merge);
+            continue;
+        }
+        if (read_marker(feed, &date) != VALID) return feed->line;
+
+        feed->date = date;              /* Waits for the feeds still on earlier days */
+        feed->day = date_to_day(date);
+        feed->pending = 1;
+        sift_down(merge);
+    }
+    return NULL;
+}
+
+
+void free_merge(Merge *merge) {
+    free(merge->feeds);
+    free(merge->heap);
+}
@@ -0,0 +1,78 @@
+/**
+ * @file merge.h
+ * @brief Header file for the merge of several command feeds by date.
+ *
+ * Each feed is a command log of one clinic, with `t` commands marking where
+ * its days begin. The merge hands out the commands of every feed in order of
+ * those markers, through a binary heap keyed by the day each feed has
+ * reached; feeds on the same day go in the order they were given. The
+ * commands of each feed keep their relative order.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "system.h"
+
+#define FEED_SKIPPED    "qwB"   /**< Commands ignored in a feed: they end the program or take over the input */
+
+
+/**
+ * @brief One feed being merged.
+ */
+typedef struct {
+    FILE *file;             /**< The command log */
+    Date date;              /**< Date of its last marker */
+    int day;                /**< Day number of that date, the key in the heap */
+    int pending;            /**< Non-zero if line holds a marker not handed out yet */
+    char line[MAXBUF];      /**< Last line read */
+} Feed;
+
+
+/**
+ * @brief State of a merge.
+ */
+typedef struct {
+    Feed *feeds;            /**< The feeds */
+    int *heap;              /**< Feeds not finished, as a heap of indexes */
+    int count;              /**< Number of feeds in the heap */
+} Merge;
+
+
+/**
+ * @brief Starts the merge of some feeds, all at the present date.
+ *
+ * @param merge Pointer to the merge.
+ * @param files The feeds, opened for reading.
+ * @param count Number of feeds.
+ * @param present Current system date.
+ */
+void start_merge(Merge *merge, FILE *files[], int count, Date present);
+
+
+/**
+ * @brief Gives the next command of the merge.
+ *
+ * @param merge Pointer to the merge.
+ * @return The command, valid until the next call, or NULL when every feed ended.
+ */
+char *next_merged(Merge *merge);
+
+
+/**
+ * @brief Frees the merge (the files stay open).
+ *
+ * @param merge Pointer to the merge.
+ */
+void free_merge(Merge *merge);
+
+
+#endif
@@ -23,7 +23,29 @@
 #include "vaccine.h"
 #include "inoculation.h"
 #include "user.h"
+#include "catalog.h"
+#include "cold.h"
 #include "system.h"
+#include "manifest.h"
+#include "export.h"
+#include "sorter.h"
+#include "journal.h"
+#include "board.h"
+#include "merge.h"
+#include "history.h"
+#include "cohort.h"
+#include "protocol.h"
+#include "ranking.h"
+
+
+/**
+ * @brief Runs one command line.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ * @return Non-zero if the command was q.
+ */
+int run_command(char *buf, Sys *sys);
 
 
 /**
@@ -36,9 +58,17 @@ void command_q(Sys *sys) {
     for (i = 0; i < sys->entries; i++) {
         free_vaccine(sys->batch_list[i]);
     }
-    free_list_ino(sys->inolink->head);
+    free_segments(sys->inolink);
+    free_list_ino(sys->inolink);
     free_user(sys->user);
     free(sys->inolink);
+    free_catalog(&sys->catalog);
+    free_cache(&sys->cache);
+    free_journal(&sys->journal);
+    close_board(&sys->board);
+    free_history(&sys->history);
+    free_executor(&sys->executor);
+    free_archive(&sys->archive);
 }
 
 
@@ -53,11 +83,15 @@ void command_c(char *buf, Sys *sys) {
     Vaccine *batch = malloc(sizeof(Vaccine));
     if (sys->entries == MAX_BRATCH) {
         puts(TOO_MANY(sys->language));
-        free_vaccine(batch);
+        free(batch);
         return;
     }
 
     read_vaccine(sys->batch_list, batch, sys->entries, &error, buf, sys->present); 
+    if (error == 0 && archive_find(&sys->archive, batch->batch) != NULL) {   /* An archived batch keeps its code */
+        free(batch->name);
+        error = NUM_DUP_BATCH;
+    }
 
     if (error != 0) {
         switch (error) {
@@ -72,8 +106,8 @@ void command_c(char *buf, Sys *sys) {
     }
 
     else {
-    add_batch(sys->batch_list, batch, sys->entries);
-    (sys->entries)++;
+    insert_batch(sys, batch);
+    journal_batch(&sys->journal, batch);
     printf("%s\n",batch->batch);
     }
 }
@@ -86,25 +120,23 @@ void command_c(char *buf, Sys *sys) {
  */
 void command_l(char *buf, Sys *sys) {  
     char *segment;
-    Vaccine *list[MAX_BRATCH];      // elems that are going to be printed
-    int count;                     // number of elems
+    int name_id;
     segment = strtok(buf, SPACE);
     segment = strtok(NULL, SPACE);
 
     if (segment != NULL) { 
         while (segment != NULL) {       /* read all the vaccine names that are on the input*/
             segment[strcspn(segment, "\n")] = '\0';
-            count = search_vaccine(sys->batch_list, sys->entries, segment, list);
-            if (count == 0) {
+            name_id = find_name(&sys->catalog, segment);
+            if (name_id == NO_NAME || cache_print_name(&sys->cache, &sys->catalog, sys->batch_list, sys->entries, name_id) == 0) {
                 printf("%s%s\n", segment, NO_VAC_FOUND(sys->language));
             }
-            print_list(list, count);
             segment = strtok(NULL, SPACE);
         }
     }
 
     else  {
-        print_list(sys->batch_list, sys->entries);
+        cache_print_all(&sys->cache, sys->batch_list, sys->entries);
     }
 }
 
@@ -115,38 +147,30 @@ void command_l(char *buf, Sys *sys) {
  * @param sys Pointer to the system structure.
  */
 void command_a(char *buf, Sys *sys) {
-    int i = START, k = START, size_list;
-    Vaccine *vac_list[MAX_BRATCH];
-    LinkInl new_inoculation = malloc(sizeof(struct inoculation));
-    char *segment = strtok(buf, SPACE), vaccine_name[NAME_SIZE], *name = malloc(sizeof(char) * 200);
+    int i = START, k, size;
+    LinkInl new_inoculation;
+    char *segment = strtok(buf, SPACE), *vaccine_name, *name;
      
     segment = strtok(NULL, "\n");
+    if (segment == NULL) return;
 
-    read_username(segment, &(name), &i);
+    name = read_username(segment, &i, &size);
 
     while(segment[i] == ' ') i++;   /* Goes to the next space */
-    strcpy(vaccine_name, &segment[i]);  
-    size_list = search_vaccine(sys->batch_list, sys->entries, vaccine_name, vac_list);
+    vaccine_name = &segment[i];
+    k = catalog_first_eligible(&sys->catalog, sys->entries,     /* Gets the index of the oldest batch */
+            find_name(&sys->catalog, vaccine_name), date_to_day(sys->present));
 
-    while(k < size_list) {
-        if (past_date(vac_list[k]->date, sys->present) > 0 && vac_list[k]->dose > 0) break;
-        k++;        /* Gets the index of the oldest batch */
-    }
-    if (k == size_list) {   /* if k >= size_list means that it didnt found any vaccine */
-        free(name); free_inoculation(new_inoculation);
+    if (k == NO_ELIGIBLE) {     /* Didnt found any vaccine */
         puts(NO_STOCK(sys->language));
         return;
     }
-    new_inoculation->date = sys->present;
-    new_inoculation->vaccine = vac_list[k];
-
-    if (comp_inoculation(sys->user, sys->present, name, vaccine_name) != VALID) {
-        free(name); free_inoculation(new_inoculation);
+    if (comp_inoculation(sys->user, sys->inolink, sys->present, name, size, vaccine_name) != VALID) {
         puts(ALREADY(sys->language));
         return;
     }
-    insert_hash(sys->user, new_inoculation, name);
-    add_inoculation(sys->inolink, new_inoculation);
+    new_inoculation = apply_dose(sys, k, name, size, sys->present);
+    journal_inoculation(&sys->journal, new_inoculation);
     printf("%s\n", new_inoculation->vaccine->batch);
 }
 
@@ -157,24 +181,45 @@ void command_a(char *buf, Sys *sys) {
  * @param sys Pointer to the system structure.
  */
 void command_r(char *buf, Sys *sys) {
-    int i;
+    int i, uses;
     char batch[BATCH_SIZE];
+    Vaccine *archived;
 
     sscanf(buf, "r %20s", batch);
 
-    for (i = 0; i < sys->entries; i++) {
-        if (strcmp(batch, sys->batch_list[i]->batch) == 0) {
-            if (sys->batch_list[i]->uses == 0){ 
-                remove_batch(sys->batch_list, &sys->entries, i);
-            }
-            else {
-                sys->batch_list[i]->dose = 0;
-            }
-            printf("%d\n", sys->batch_list[i]->uses);
-            return;
-        }
+    if ((i = catalog_find(&sys->catalog, sys->batch_list, sys->entries, batch)) == NUM_NO_BATCH) {
+        if ((archived = archive_find(&sys->archive, batch)) != NULL)    /* Expired, it has no doses left to withdraw */
+            printf("%d\n", archived->uses);
+        else printf("%s%s\n", batch, NO_BATCH_FOUND(sys->language));
+        return;
+    }
+    uses = withdraw_batch(sys, i);
+    journal_withdraw(&sys->journal, batch);
+    printf("%d\n", uses);
+}
+
+
+/**
+ * @brief Lists every user that received a dose from a batch (recall).
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_b(char *buf, Sys *sys) {
+    int i;
+    char batch[BATCH_SIZE];
+    Vaccine *vaccine;
+
+    if (sscanf(buf, "b %20s", batch) != 1) return;
+
+    i = catalog_find(&sys->catalog, sys->batch_list, sys->entries, batch);
+    vaccine = (i != NUM_NO_BATCH) ? sys->batch_list[i] : archive_find(&sys->archive, batch);
+    if (vaccine == NULL) {
+        printf("%s%s\n", batch, NO_BATCH_FOUND(sys->language));
+        return;
     }
-   printf("%s%s\n", batch, NO_BATCH_FOUND(sys->language));
+    print_cold_batch(sys->inolink, batch);
+    print_batch(vaccine);
 }
 
 
@@ -185,30 +230,27 @@ void command_r(char *buf, Sys *sys) {
  * @param sys Pointer to the system structure.
  */
 void command_d(char *buf, Sys *sys) {
-    int result, check, i = START;
+    int result, check, size, i = START;
     char *name, date[DATE_SIZE], batch[BATCH_SIZE], *segment;
 
     segment = strtok(buf, SPACE); 
     segment = strtok(NULL, "\n");
+    if (segment == NULL) return;
 
-    name = malloc(sizeof(char) * 200);
-    read_username(segment, &name, &i);
-    if (segment[i - 1] != '\0') {   /* There is something after the l command*/
-        check = sscanf(&segment[i], "%12s %20s", date, batch);
-    } 
-    else {          /* There is nothing after the l command */
-        check = 0;
-    }
+    name = read_username(segment, &i, &size);
+    check = sscanf(&segment[i], "%12s %20s", date, batch);
+    if (check < 0) check = ONLY_NAME;       /* There is nothing after the name */
 
-    result = remove_application(sys->inolink, sys->user, sys->present, name, date, batch, check);
+    result = delete_applications(sys, name, size, date, batch, check);
 
+    if (result > 0)     /* A count can match an error code; replaying a rejected removal changes nothing */
+        journal_delete(&sys->journal, check, date, batch, name, size);
     switch (result){
-        case NO_USER_NUM: printf("%s%s\n",name, NO_USER(sys->language)); break;
+        case NO_USER_NUM: printf("%.*s%s\n", size, name, NO_USER(sys->language)); break;
         case NUM_INV_DATE: puts(INV_DATE(sys->language)); break;
         case NUM_NO_BATCH: printf("%s%s\n", batch, NO_BATCH_FOUND(sys->language)); break;
         default: printf("%d\n",result); break;
     }
-    free(name);
 }
 
 
@@ -225,6 +267,7 @@ void command_u(char *buf, Sys *sys) {
 
 
     if (*name == '\0') {        /* There is no name */
+        print_cold(sys->inolink, stdout, TEXT_FORMAT);
         print_inoculations(sys->inolink->last);
         return;
     }
@@ -234,14 +277,15 @@ void command_u(char *buf, Sys *sys) {
     name[strcspn(name, "\n")] = '\0';
     if (div == 1) name[strcspn(name, "\"")] = '\0';
 
-    find_hash(sys->user, name, &user);
+    find_hash(sys->user, name, strlen(name), &user);
 
     if (user == NULL) {
         printf("%s%s\n", name, NO_USER(sys->language));
         return;
     }
 
-    print_user(user);
+    print_cold_user(sys->inolink, user, stdout, TEXT_FORMAT);
+    print_user(sys->inolink, user);
 }
 
 
@@ -262,12 +306,664 @@ void command_t(char *buf, Sys *sys) {
         puts(INV_DATE(sys->language));
         return;
     }
-    sys->present = date;
+    advance_date(sys, date);
     print_date(sys->present);
     printf("\n");
 }
 
 
+/**
+ * @brief Sets (or prints) the age, in days, after which inoculations move to the cold tier.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_k(char *buf, Sys *sys) {
+    int days;
+    char *segment = strtok(buf, SPACE);
+
+    segment = strtok(NULL, SPACE);
+    if (segment != NULL) {
+        if (sscanf(segment, "%d", &days) != 1 || days < 0) {
+            puts(INV_QTY(sys->language));
+            return;
+        }
+        sys->inolink->horizon = days;
+    }
+    printf("%d\n", sys->inolink->horizon);
+}
+
+
+/**
+ * @brief Lists the inoculations applied between two dates, optionally for one vaccine.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_i(char *buf, Sys *sys) {
+    Date first, end;
+    int name_id = NO_NAME;
+    char *segment;
+
+    segment = strtok(buf, SPACE);
+    segment = strtok(NULL, SPACE);
+    if (parse_date(segment, &first) != VALID) {
+        puts(INV_DATE(sys->language));
+        return;
+    }
+    segment = strtok(NULL, SPACE);
+    if (parse_date(segment, &end) != VALID || past_date(first, end) > 0) {
+        puts(INV_DATE(sys->language));
+        return;
+    }
+
+    segment = strtok(NULL, SPACE);      /* Optional vaccine name */
+    if (segment != NULL) {
+        segment[strcspn(segment, "\n")] = '\0';
+        if ((name_id = find_name(&sys->catalog, segment)) == NO_NAME) {
+            printf("%s%s\n", segment, NO_VAC_FOUND(sys->language));
+            return;
+        }
+    }
+
+    print_cold_range(sys->inolink, date_to_day(first), date_to_day(end), name_id);
+    print_range(sys->inolink, date_to_day(first), date_to_day(end), name_id);
+}
+
+
+/**
+ * @brief Prints the memory used per user by the user records.
+ * 
+ * @param sys Pointer to the system structure.
+ */
+void command_m(Sys *sys) {
+    print_memory(sys->user);
+}
+
+
+/**
+ * @brief Imports the batches and historical inoculations of a manifest file.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_f(char *buf, Sys *sys) {
+    FILE *file;
+    char *segment = strtok(buf, SPACE);
+
+    segment = strtok(NULL, "\n");
+    if (segment == NULL) return;
+    if ((file = fopen(segment, "r")) == NULL) {
+        printf("%s%s\n", segment, NO_FILE(sys->language));
+        return;
+    }
+    import_manifest(sys, file);
+    invalidate_cache(&sys->cache);
+    fclose(file);
+}
+
+
+/**
+ * @brief Exports the registry to a CSV or JSON Lines file.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_x(char *buf, Sys *sys) {
+    FILE *file;
+    int format, order = BY_DATE;
+    char *segment = strtok(buf, SPACE), *path;
+
+    format = read_format(strtok(NULL, " \n"));
+    path = strtok(NULL, " \n");
+    segment = strtok(NULL, " \n");
+    if (format == TEXT_FORMAT || path == NULL) {
+        puts(INV_FORMAT(sys->language));
+        return;
+    }
+    if (segment != NULL && strcmp(segment, "user") == 0) order = BY_USER;
+    else if (segment != NULL && strcmp(segment, "date") != 0) {
+        puts(INV_FORMAT(sys->language));
+        return;
+    }
+    if ((file = fopen(path, "w")) == NULL) {
+        printf("%s%s\n", path, NO_FILE(sys->language));
+        return;
+    }
+    printf("%d\n", export_registry(sys, file, format, order));
+    fclose(file);
+}
+
+
+/**
+ * @brief Starts (or reports) the replication journal of a primary instance.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_j(char *buf, Sys *sys) {
+    char *segment = strtok(buf, SPACE);
+
+    segment = strtok(NULL, "\n");
+    if (segment != NULL && open_journal(sys, segment) != VALID) {
+        printf("%s%s\n", segment, NO_FILE(sys->language));
+        return;
+    }
+    printf("%ld %ld\n", sys->journal.written, read_ack(&sys->journal));
+}
+
+
+/**
+ * @brief Makes the instance a follower of a journal, or reports its lag.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_y(char *buf, Sys *sys) {
+    char *segment = strtok(buf, SPACE);
+
+    segment = strtok(NULL, "\n");
+    if (segment != NULL && sys->journal.source == NULL && follow_journal(sys, segment) != VALID) {
+        printf("%s%s\n", segment, NO_FILE(sys->language));
+        return;
+    }
+    printf("%ld %ld %ld\n", sys->journal.applied, sys->journal.backlog, sys->journal.max_backlog);
+}
+
+
+/**
+ * @brief Publishes the catalog to a file read by other processes, or prints its version.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_g(char *buf, Sys *sys) {
+    char *segment = strtok(buf, SPACE);
+
+    segment = strtok(NULL, "\n");
+    if (segment != NULL && open_board(&sys->board, segment, sys->batch_list, sys->entries) != VALID) {
+        printf("%s%s\n", segment, NO_FILE(sys->language));
+        return;
+    }
+    printf("%llu\n", sys->board.header.seq);
+}
+
+
+/**
+ * @brief Lists every inoculation sorted by user or by vaccine within a memory budget.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_s(char *buf, Sys *sys) {
+    int order;
+    long budget = SORT_BUDGET;
+    char *segment = strtok(buf, SPACE);
+
+    segment = strtok(NULL, " \n");
+    if (segment != NULL && strcmp(segment, "user") == 0) order = SORT_BY_USER;
+    else if (segment != NULL && strcmp(segment, "vaccine") == 0) order = SORT_BY_VACCINE;
+    else {
+        puts(INV_ORDER(sys->language));
+        return;
+    }
+    segment = strtok(NULL, " \n");
+    if (segment != NULL && (sscanf(segment, "%ld", &budget) != 1 || budget < SORT_MIN)) {
+        puts(INV_QTY(sys->language));
+        return;
+    }
+    sorted_listing(sys, order, budget);
+}
+
+
+/**
+ * @brief Prints a page of batches, after the batch of the cursor.
+ * 
+ * @param sys Pointer to the system structure.
+ * @param limit Maximum number of batches.
+ * @param cursor Cursor "<expiry day>.<batch>" of the previous page, or NULL.
+ */
+void page_batches(Sys *sys, int limit, char *cursor) {
+    int day, start = START, count;
+    Vaccine target;
+
+    if (cursor != NULL) {       /* Resumes by binary search on the ordered batch list */
+        if (sscanf(cursor, "%d.%20s", &day, target.batch) != 2 || day < START) {
+            puts(INV_CURSOR(sys->language));
+            return;
+        }
+        target.date = day_to_date(day);
+        pack_batch(target.batch, &target.key);
+        start = binary_search(sys->batch_list, sys->entries, &target);
+    }
+    count = (sys->entries - start < limit) ? sys->entries - start : limit;
+    print_list(sys->batch_list + start, count);
+    if (start + count < sys->entries)
+        printf("%s %d.%s\n", NEXT_PAGE, date_to_day(sys->batch_list[start + count - 1]->date),
+                sys->batch_list[start + count - 1]->batch);
+}
+
+
+/**
+ * @brief Prints a page of inoculations in date order, after the position of the cursor.
+ * 
+ * @param sys Pointer to the system structure.
+ * @param limit Maximum number of inoculations.
+ * @param cursor Cursor "<day>.<sequence number>" of the last inoculation of the previous page, or NULL.
+ */
+void page_inoculations(Sys *sys, int limit, char *cursor) {
+    int day = START, count;
+    unsigned int seq = START;
+
+    if (cursor != NULL && (sscanf(cursor, "%d.%u", &day, &seq) != 2 || day < START)) {
+        puts(INV_CURSOR(sys->language));
+        return;
+    }
+    count = print_cold_page(sys->inolink, &day, &seq, limit);
+    count += print_page(sys->inolink, &day, &seq, limit - count);
+    if (count == limit && (more_cold(sys->inolink, day, seq) || more_inoculations(sys->inolink, day, seq)))
+        printf("%s %d.%u\n", NEXT_PAGE, day, seq);
+}
+
+
+/**
+ * @brief Prints the batches with the most doses left, in the format of `l`.
+ * 
+ * @param sys Pointer to the system structure.
+ * @param k Maximum number of batches.
+ */
+void top_batches(Sys *sys, int k) {
+    int i, count;
+    Ranking ranking;
+
+    start_ranking(&ranking, k);
+    for (i = 0; i < sys->entries; i++)
+        rank_item(&ranking, sys->batch_list[i], sys->batch_list[i]->dose);
+    count = finish_ranking(&ranking);
+    for (i = 0; i < count; i++)
+        print_list((Vaccine**) &ranking.heap[i].item, 1);
+    free_ranking(&ranking);
+}
+
+
+/**
+ * @brief Prints the users with the most applications, with their number.
+ * 
+ * @param sys Pointer to the system structure.
+ * @param k Maximum number of users.
+ */
+void top_users(Sys *sys, int k) {
+    int i, count;
+    Ranking ranking;
+    User *user;
+
+    start_ranking(&ranking, k);
+    for (i = 0; i < sys->user->size; i++) {
+        for (user = sys->user->user_list[i]; user != NULL; user = user->next)
+            rank_item(&ranking, user, user->count + user->cold);
+    }
+    count = finish_ranking(&ranking);
+    for (i = 0; i < count; i++) {
+        user = ranking.heap[i].item;
+        printf("%.*s %d\n", user->size, user->name, user->count + user->cold);
+    }
+    free_ranking(&ranking);
+}
+
+
+/**
+ * @brief Prints one page of the l or u listing.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_p(char *buf, Sys *sys) {
+    int limit;
+    char *segment = strtok(buf, SPACE), *listing, *cursor;
+
+    listing = strtok(NULL, " \n");
+    segment = strtok(NULL, " \n");
+    cursor = strtok(NULL, " \n");
+    if (listing == NULL || (strcmp(listing, "l") != 0 && strcmp(listing, "u") != 0)) {
+        puts(INV_ORDER(sys->language));
+        return;
+    }
+    if (segment == NULL || sscanf(segment, "%d", &limit) != 1 || limit <= 0) {
+        puts(INV_QTY(sys->language));
+        return;
+    }
+    if (cursor != NULL && strcmp(cursor, TOP_PAGE) == 0) {
+        if (*listing == 'l') top_batches(sys, limit);
+        else top_users(sys, limit);
+    }
+    else if (*listing == 'l') page_batches(sys, limit, cursor);
+    else page_inoculations(sys, limit, cursor);
+}
+
+
+/**
+ * @brief Replays several command feeds merged by their date markers.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ * @return Non-zero if a command of the feeds ended the program.
+ */
+int command_w(char *buf, Sys *sys) {
+    int i, count = START, end = START;
+    FILE **files = malloc(sizeof(FILE*) * (strlen(buf) / 2 + 1));     /* At most one file per two characters */
+    char *segment = strtok(buf, SPACE), *line;
+    Merge merge;
+
+    for (segment = strtok(NULL, " \n"); segment != NULL; segment = strtok(NULL, " \n")) {
+        if ((files[count] = fopen(segment, "r")) == NULL) {
+            printf("%s%s\n", segment, NO_FILE(sys->language));
+            for (i = 0; i < count; i++)
+                fclose(files[i]);
+            free(files);
+            return 0;
+        }
+        count++;
+    }
+
+    start_merge(&merge, files, count, sys->present);
+    while (!end && (line = next_merged(&merge)) != NULL) {
+        if (line[0] == '\0' || strchr(FEED_SKIPPED, line[0]) == NULL)     /* A feed cannot end the program */
+            end = run_command(line, sys);
+    }
+    free_merge(&merge);
+    for (i = 0; i < count; i++)
+        fclose(files[i]);
+    free(files);
+    return end;
+}
+
+
+/**
+ * @brief Lists the batches or the applications as they were at the end of an earlier day.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_h(char *buf, Sys *sys) {
+    Date date;
+    char *segment = strtok(buf, SPACE), *kind, *name;
+
+    segment = strtok(NULL, " \n");
+    if (parse_date(segment, &date) != VALID || date.year < FIRST_YEAR || past_date(date, sys->present) > 0) {
+        puts(INV_DATE(sys->language));
+        return;
+    }
+    kind = strtok(NULL, " \n");
+    if (kind != NULL && strcmp(kind, "l") == 0) {
+        print_batches_at(&sys->history, &sys->catalog, date_to_day(date));
+        return;
+    }
+    if (kind == NULL || strcmp(kind, "u") != 0) return;
+
+    name = strtok(NULL, "\n");
+    if (name == NULL) {
+        print_inoculations_at(&sys->history, NULL, 0, date_to_day(date));
+        return;
+    }
+    if (*name == '"') {         /* Quoted name */
+        name++;
+        name[strcspn(name, "\"")] = '\0';
+    }
+    if (print_inoculations_at(&sys->history, name, strlen(name), date_to_day(date)) == 0)
+        printf("%s%s\n", name, NO_USER(sys->language));
+}
+
+
+/**
+ * @brief Applies a vaccine to a list of users, or to the users of a file.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_o(char *buf, Sys *sys) {
+    int i = START, size;
+    char *segment = strtok(buf, SPACE), *vaccine, *name, line[MAXBUF];
+    FILE *file;
+    Cohort cohort;
+
+    vaccine = strtok(NULL, " \n");
+    segment = strtok(NULL, "\n");
+    if (vaccine == NULL || segment == NULL) return;
+
+    if (segment[0] == COHORT_FILE) {
+        if ((file = fopen(segment + 1, "r")) == NULL) {
+            printf("%s%s\n", segment + 1, NO_FILE(sys->language));
+            return;
+        }
+        start_cohort(sys, &cohort, vaccine);
+        while (fgets(line, MAXBUF, file) != NULL) {     /* One user per line, quoted or not */
+            line[strcspn(line, "\r\n")] = '\0';
+            name = line;
+            if (*name == '"') {
+                name++;
+                name[strcspn(name, "\"")] = '\0';
+            }
+            if (*name != '\0') cohort_apply(sys, &cohort, name, strlen(name));
+        }
+        fclose(file);
+        return;
+    }
+
+    start_cohort(sys, &cohort, vaccine);
+    while (segment[i] != '\0') {
+        name = read_username(segment, &i, &size);
+        if (size > 0) cohort_apply(sys, &cohort, name, size);
+        while (segment[i] == ' ') i++;
+    }
+}
+
+
+/**
+ * @brief Sets (or prints) the number of commands read ahead of their execution.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_e(char *buf, Sys *sys) {
+    int window;
+    char *segment = strtok(buf, SPACE);
+
+    segment = strtok(NULL, SPACE);
+    if (segment != NULL) {
+        if (sscanf(segment, "%d", &window) != 1 || window < 1 || window > MAX_WINDOW) {
+            puts(INV_QTY(sys->language));
+            return;
+        }
+        set_window(&sys->executor, window);
+    }
+    printf("%d\n", sys->executor.window);
+}
+
+
+/**
+ * @brief Deletes every inoculation applied before a date.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_z(char *buf, Sys *sys) {
+    char date[DATE_SIZE];
+    Date cutoff;
+
+    if (sscanf(buf, "z %12s", date) != 1 || parse_date(date, &cutoff) != VALID ||
+            past_date(cutoff, sys->present) > 0) {
+        puts(INV_DATE(sys->language));
+        return;
+    }
+    printf("%d\n", purge_applications(sys, cutoff));
+    journal_purge(&sys->journal, cutoff);
+}
+
+
+/**
+ * @brief Turns on or off (or prints) the reclamation of expired batches by `t`.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_R(char *buf, Sys *sys) {
+    int reclaim;
+    char *segment = strtok(buf, SPACE);
+
+    segment = strtok(NULL, SPACE);
+    if (segment != NULL) {
+        if (sscanf(segment, "%d", &reclaim) != 1 || reclaim < 0 || reclaim > 1) {
+            puts(INV_QTY(sys->language));
+            return;
+        }
+        sys->archive.reclaim = reclaim;
+    }
+    printf("%d\n", sys->archive.reclaim);
+}
+
+
+/**
+ * @brief Prints the distinct users of a vaccine, overall or on a date, or sets
+ * (or prints) the precision of the counts.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_v(char *buf, Sys *sys) {
+    int name_id, precision, users;
+    double error;
+    char *segment = strtok(buf, SPACE), *vaccine;
+    Date date;
+
+    vaccine = strtok(NULL, " \n");
+    if (vaccine == NULL) return;
+    segment = strtok(NULL, " \n");
+
+    if (strcmp(vaccine, COVERAGE_MODE) == 0) {
+        if (segment != NULL) {
+            if (sscanf(segment, "%d", &precision) != 1 || (precision != EXACT &&
+                    (precision < MIN_PRECISION || precision > MAX_PRECISION))) {
+                puts(INV_QTY(sys->language));
+                return;
+            }
+            history_coverage(&sys->history, precision);
+        }
+        printf("%d\n", sys->history.coverage.precision);
+        return;
+    }
+
+    if ((name_id = find_name(&sys->catalog, vaccine)) == NO_NAME) {
+        printf("%s%s\n", vaccine, NO_VAC_FOUND(sys->language));
+        return;
+    }
+    if (segment != NULL) {
+        if (parse_date(segment, &date) != VALID || date.year < FIRST_YEAR || past_date(date, sys->present) > 0) {
+            puts(INV_DATE(sys->language));
+            return;
+        }
+        printf("%s %s %d\n", vaccine, segment, coverage_day(&sys->history.coverage, name_id, date_to_day(date)));
+        return;
+    }
+    users = coverage_users(&sys->history.coverage, name_id, &error);
+    if (sys->history.coverage.precision == EXACT) printf("%s %d\n", vaccine, users);
+    else printf("%s %d +-%.1f\n", vaccine, users, error);
+}
+
+
+/**
+ * @brief Prints the doses of a vaccine administered and expired on each day of a range.
+ * 
+ * @param buf Input buffer containing the command.
+ * @param sys Pointer to the system structure.
+ */
+void command_S(char *buf, Sys *sys) {
+    int name_id;
+    char *segment = strtok(buf, SPACE), *vaccine;
+    Date first, last;
+
+    vaccine = strtok(NULL, " \n");
+    if (vaccine == NULL) return;
+    if ((name_id = find_name(&sys->catalog, vaccine)) == NO_NAME) {
+        printf("%s%s\n", vaccine, NO_VAC_FOUND(sys->language));
+        return;
+    }
+    segment = strtok(NULL, " \n");
+    if (parse_date(segment, &first) != VALID || first.year < FIRST_YEAR) {
+        puts(INV_DATE(sys->language));
+        return;
+    }
+    segment = strtok(NULL, " \n");
+    if (parse_date(segment, &last) != VALID || past_date(first, last) > 0) {
+        puts(INV_DATE(sys->language));
+        return;
+    }
+    print_series(&sys->history.series, name_id, date_to_day(first), date_to_day(last));
+}
+
+
+/**
+ * @brief Switches the input and output to the binary protocol until the program ends.
+ * 
+ * @param sys Pointer to the system structure.
+ * @return Non-zero if the binary session ran, ending the program.
+ */
+int command_B(Sys *sys) {
+    if (sys->executor.window != 1) {        /* The window may have read requests as text */
+        puts(INV_MODE(sys->language));
+        return 0;
+    }
+    fflush(stdout);
+    serve_binary(sys, stdin, stdout);
+    return 1;
+}
+
+
+int run_command(char *buf, Sys *sys) {
+    if (sys->journal.source != NULL) {      /* A follower first applies what the primary wrote */
+        catch_up(sys);
+        if (buf[0] != '\0' && strchr(WRITE_COMMANDS, buf[0]) != NULL) {
+            puts(READ_ONLY(sys->language));
+            return 0;
+        }
+    }
+    switch (buf[0]) {
+        case 'q': command_q(sys); return 1;
+        case 'c': command_c(buf, sys); break;
+        case 'l': command_l(buf, sys); break;
+        case 'a': command_a(buf, sys); break;
+        case 'r': command_r(buf, sys); break;
+        case 'd': command_d(buf, sys); break;
+        case 'u': command_u(buf, sys); break;
+        case 't': command_t(buf, sys); break;
+        case 'i': command_i(buf, sys); break;
+        case 'b': command_b(buf, sys); break;
+        case 'm': command_m(sys); break;
+        case 'k': command_k(buf, sys); break;
+        case 'f': command_f(buf, sys); break;
+        case 'x': command_x(buf, sys); break;
+        case 's': command_s(buf, sys); break;
+        case 'p': command_p(buf, sys); break;
+        case 'j': command_j(buf, sys); break;
+        case 'y': command_y(buf, sys); break;
+        case 'g': command_g(buf, sys); break;
+        case 'w': return command_w(buf, sys);
+        case 'h': command_h(buf, sys); break;
+        case 'o': command_o(buf, sys); break;
+        case 'e': command_e(buf, sys); break;
+        case 'z': command_z(buf, sys); break;
+        case 'R': command_R(buf, sys); break;
+        case 'v': command_v(buf, sys); break;
+        case 'S': command_S(buf, sys); break;
+        case 'B':
+            if (!command_B(sys)) break;
+            command_q(sys);
+            return 1;
+        default: break;
+    }
+    return 0;
+}
+
+
 /**
  * @brief Main function. Initializes the system and handles command dispatching.
  * 
@@ -278,21 +974,23 @@ void command_t(char *buf, Sys *sys) {
 int main(int arg1, char **arg2) {
     Sys sys;
     char buf[MAXBUF];
+    int i, count;
     (void)arg2;
 
     start_sys(&sys, arg1);
 
     while (fgets(buf, MAXBUF, stdin)) {
-        switch (buf[0]) {
-            case 'q': command_q(&sys); return 0;
-            case 'c': command_c(buf, &sys); break;
-            case 'l': command_l(buf, &sys); break;
-            case 'a': command_a(buf, &sys); break;
-            case 'r': command_r(buf, &sys); break;
-            case 'd': command_d(buf, &sys); break;
-            case 'u': command_u(buf, &sys); break;
-            case 't': command_t(buf, &sys); break;
-            default: break;
+        if (sys.executor.window == 1) {
+            if (run_command(buf, &sys)) return 0;
+            continue;
+        }
+        count = read_window(&sys.executor, buf, stdin);     /* Prefetches the users, then runs in order */
+        prefetch_window(&sys.executor, sys.user);
+        for (i = 0; i < count; i++) {
+            strcpy(buf, window_command(&sys.executor, i));
+            prepare_command(&sys.executor, sys.user, i, buf);
+            if (run_command(buf, &sys)) return 0;
+            sys.user->hint = NULL;
         }
     }
     return 0;
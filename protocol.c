@@ -0,0 +1,433 @@
+/**
+ * @file protocol.c
+ * @brief Implements the binary protocol used by programs instead of the text commands.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+#include "user.h"
+#include "catalog.h"
+#include "cold.h"
+#include "system.h"
+#include "journal.h"
+#include "archive.h"
+#include "export.h"
+#include "protocol.h"
+
+
+/**
+ * @brief Payload of a request and the texts unpacked from it.
+ */
+typedef struct {
+    unsigned char *data;    /**< Bytes of the payload */
+    int size;               /**< Length of the payload */
+    int used;               /**< Bytes already unpacked */
+    int capacity;           /**< Size of the tables of bytes and texts */
+    char *texts;            /**< Null-terminated copies of the texts */
+    int texts_used;         /**< Bytes of the texts in use */
+    int short_frame;        /**< Non-zero if a field ran past the end of the payload */
+} Request;
+
+
+void put_number(FILE *out, unsigned long value, int bytes) {
+    int i;
+    for (i = 0; i < bytes; i++)
+        putc((int) ((value >> (8 * i)) & 0xFF), out);
+}
+
+
+void put_text(FILE *out, char *text, int size) {
+    put_number(out, size, TEXT_BYTES);
+    fwrite(text, 1, size, out);
+}
+
+
+void put_date(FILE *out, Date date) {
+    put_number(out, date.day, 1);
+    put_number(out, date.month, 1);
+    put_number(out, date.year, 2);
+}
+
+
+/**
+ * @brief Writes the frame that ends a request, with no values.
+ */
+static void reply(FILE *out, int status) {
+    put_number(out, 1, LENGTH_BYTES);
+    put_number(out, status, 1);
+}
+
+
+/**
+ * @brief Writes the frame that ends a request that succeeded, with a text.
+ */
+static void reply_text(FILE *out, char *text) {
+    int size = strlen(text);
+
+    put_number(out, 1 + TEXT_BYTES + size, LENGTH_BYTES);
+    put_number(out, STATUS_OK, 1);
+    put_text(out, text, size);
+}
+
+
+/**
+ * @brief Writes the frame that ends a request that succeeded, with a number.
+ */
+static void reply_number(FILE *out, int value) {
+    put_number(out, 1 + INT_BYTES, LENGTH_BYTES);
+    put_number(out, STATUS_OK, 1);
+    put_number(out, (unsigned long) value, INT_BYTES);
+}
+
+
+/**
+ * @brief Reads a little-endian number from a stream.
+ *
+ * @return 0 if the stream ended first.
+ */
+static int read_number(FILE *in, unsigned long *value, int bytes) {
+    int i, c;
+
+    *value = 0;
+    for (i = 0; i < bytes; i++) {
+        if ((c = getc(in)) == EOF) return 0;
+        *value |= (unsigned long) c << (8 * i);
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Discards the payload of a frame that is not kept.
+ *
+ * @return 0 if the input ended.
+ */
+static int skip_payload(FILE *in, unsigned long size) {
+    char buffer[BUFSIZ];
+    size_t chunk;
+
+    while (size > 0) {
+        chunk = (size > sizeof(buffer)) ? sizeof(buffer) : (size_t) size;
+        if (fread(buffer, 1, chunk, in) != chunk) return 0;
+        size -= chunk;
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Reads the next request.
+ *
+ * A payload longer than MAX_FRAME, or one that does not fit in memory, is
+ * skipped and left empty, so the request is answered with CODE_INV_FRAME.
+ *
+ * @return 0 if the input ended.
+ */
+static int read_request(FILE *in, Request *request) {
+    unsigned long size;
+    unsigned char *data;
+    char *texts;
+
+    if (!read_number(in, &size, LENGTH_BYTES)) return 0;
+    request->size = START;
+    request->used = START;
+    request->texts_used = START;
+    request->short_frame = START;
+    if (size > MAX_FRAME) return skip_payload(in, size);
+    if ((int) size + 1 > request->capacity) {
+        if ((data = realloc(request->data, size + 1)) == NULL) return skip_payload(in, size);
+        request->data = data;
+        if ((texts = realloc(request->texts, size + 1)) == NULL) return skip_payload(in, size);
+        request->texts = texts;
+        request->capacity = (int) size + 1;
+    }
+    if (fread(request->data, 1, size, in) != size) return 0;
+    request->size = (int) size;
+    return 1;
+}
+
+
+/**
+ * @brief Unpacks a little-endian number.
+ */
+static unsigned long get_number(Request *request, int bytes) {
+    int i;
+    unsigned long value = 0;
+
+    if (request->used + bytes > request->size) {
+        request->short_frame = 1;
+        return 0;
+    }
+    for (i = 0; i < bytes; i++)
+        value |= (unsigned long) request->data[request->used++] << (8 * i);
+    return value;
+}
+
+
+/**
+ * @brief Unpacks a text into a null-terminated copy; its length prefix leaves room for the terminator.
+ */
+static char *get_text(Request *request) {
+    int size = (int) get_number(request, TEXT_BYTES);
+    char *text = request->texts + request->texts_used;
+
+    if (request->used + size > request->size) {
+        request->short_frame = 1;
+        size = 0;
+    }
+    memcpy(text, request->data + request->used, size);
+    text[size] = '\0';
+    request->used += size;
+    request->texts_used += size + 1;
+    return text;
+}
+
+
+/**
+ * @brief Unpacks a date.
+ */
+static Date get_date(Request *request) {
+    Date date;
+
+    date.day = (int) get_number(request, 1);
+    date.month = (int) get_number(request, 1);
+    date.year = (int) get_number(request, 2);
+    return date;
+}
+
+
+/**
+ * @brief Registers a batch, with the checks of `c`.
+ */
+static void binary_create(Sys *sys, Request *request, FILE *out) {
+    char *batch = get_text(request), *name;
+    Date date = get_date(request);
+    int dose = (int) get_number(request, INT_BYTES);
+    Vaccine *vaccine;
+
+    name = get_text(request);
+    if (request->short_frame) reply(out, CODE_INV_FRAME);
+    else if (sys->entries == MAX_BRATCH) reply(out, CODE_TOO_MANY);
+    else if (check_dup_batch(sys->batch_list, batch, sys->entries) != VALID) reply(out, CODE_DUP_BATCH);
+    else if (check_inv_batch(batch) != VALID) reply(out, CODE_INV_BATCH);
+    else if (check_inv_date(date, sys->present) != VALID) reply(out, CODE_INV_DATE);
+    else if (dose <= 0) reply(out, CODE_INV_QTY);
+    else if (check_inv_name(name) != VALID) reply(out, CODE_INV_NAME);
+    else if (archive_find(&sys->archive, batch) != NULL) reply(out, CODE_DUP_BATCH);
+    else {
+        vaccine = malloc(sizeof(Vaccine));
+        strcpy(vaccine->batch, batch);
+        pack_batch(vaccine->batch, &vaccine->key);
+        vaccine->date = date;
+        vaccine->dose = dose;
+        vaccine->name = strdup(name);
+        insert_batch(sys, vaccine);
+        journal_batch(&sys->journal, vaccine);
+        reply_text(out, vaccine->batch);
+    }
+}
+
+
+/**
+ * @brief Sends the batches of a vaccine, or every batch, in the order of `l`.
+ */
+static void binary_list(Sys *sys, Request *request, FILE *out) {
+    int i, rows = START, name_id = NO_NAME;
+    char *vaccine = get_text(request);
+    Vaccine *batch;
+
+    if (request->short_frame) {
+        reply(out, CODE_INV_FRAME);
+        return;
+    }
+    if (*vaccine != '\0' && (name_id = find_name(&sys->catalog, vaccine)) == NO_NAME) {
+        reply(out, CODE_NO_VAC);
+        return;
+    }
+    for (i = 0; i < sys->entries; i++) {
+        if (name_id != NO_NAME && sys->catalog.name_id[i] != name_id) continue;
+        batch = sys->batch_list[i];
+        put_number(out, 1 + 2 * TEXT_BYTES + strlen(batch->name) + strlen(batch->batch) + DATE_BYTES +
+                2 * INT_BYTES, LENGTH_BYTES);
+        put_number(out, ROW_STATUS, 1);
+        put_text(out, batch->name, strlen(batch->name));
+        put_text(out, batch->batch, strlen(batch->batch));
+        put_date(out, batch->date);
+        put_number(out, (unsigned long) batch->dose, INT_BYTES);
+        put_number(out, (unsigned long) batch->uses, INT_BYTES);
+        rows++;
+    }
+    reply(out, (rows == 0 && name_id != NO_NAME) ? CODE_NO_VAC : STATUS_OK);
+}
+
+
+/**
+ * @brief Applies a dose, with the checks of `a`.
+ */
+static void binary_apply(Sys *sys, Request *request, FILE *out) {
+    char *name = get_text(request), *vaccine = get_text(request);
+    int k, size = strlen(name);
+    LinkInl ino;
+
+    if (request->short_frame || size == 0) {
+        reply(out, CODE_INV_FRAME);
+        return;
+    }
+    k = catalog_first_eligible(&sys->catalog, sys->entries, find_name(&sys->catalog, vaccine),
+            date_to_day(sys->present));
+    if (k == NO_ELIGIBLE) reply(out, CODE_NO_STOCK);
+    else if (comp_inoculation(sys->user, sys->inolink, sys->present, name, size,
+            vaccine) != VALID) reply(out, CODE_ALREADY);
+    else {
+        ino = apply_dose(sys, k, name, size, sys->present);
+        journal_inoculation(&sys->journal, ino);
+        reply_text(out, ino->vaccine->batch);
+    }
+}
+
+
+/**
+ * @brief Removes a batch, or withdraws its doses, as `r` does.
+ */
+static void binary_remove(Sys *sys, Request *request, FILE *out) {
+    int i;
+    char *batch = get_text(request);
+    Vaccine *archived;
+
+    if (request->short_frame) reply(out, CODE_INV_FRAME);
+    else if ((i = catalog_find(&sys->catalog, sys->batch_list, sys->entries, batch)) != NUM_NO_BATCH) {
+        reply_number(out, withdraw_batch(sys, i));
+        journal_withdraw(&sys->journal, batch);
+    }
+    else if ((archived = archive_find(&sys->archive, batch)) != NULL) reply_number(out, archived->uses);
+    else reply(out, CODE_NO_BATCH);
+}
+
+
+/**
+ * @brief Deletes applications of a user, as `d` does.
+ */
+static void binary_delete(Sys *sys, Request *request, FILE *out) {
+    char *name = get_text(request), *batch, date[DATE_SIZE];
+    int result, check = (int) get_number(request, 1), size = strlen(name);
+    Date day = get_date(request);
+
+    batch = get_text(request);
+    if (request->short_frame || size == 0 || check < ONLY_NAME || check > WITH_BATCH) {
+        reply(out, CODE_INV_FRAME);
+        return;
+    }
+    if ((unsigned) day.day > 99 || (unsigned) day.month > 99 || (unsigned) day.year > 9999)    /* Too long for `d` */
+        strcpy(date, NO_DATE);
+    else sprintf(date, "%s%d-%s%d-%d", Zero(day.day), day.day, Zero(day.month), day.month, day.year);
+    result = delete_applications(sys, name, size, date, batch, check);
+    if (result > 0) journal_delete(&sys->journal, check, date, batch, name, size);
+    switch (result) {
+        case NO_USER_NUM: reply(out, CODE_NO_USER); break;
+        case NUM_INV_DATE: reply(out, CODE_INV_DATE); break;
+        case NUM_NO_BATCH: reply(out, CODE_NO_BATCH); break;
+        default: reply_number(out, result); break;
+    }
+}
+
+
+/**
+ * @brief Sends the applications of a user, or every application, in the order of `u`.
+ */
+static void binary_user(Sys *sys, Request *request, FILE *out) {
+    int i;
+    char *name = get_text(request);
+    User *user;
+    LinkInl ino;
+
+    if (request->short_frame) {
+        reply(out, CODE_INV_FRAME);
+        return;
+    }
+    if (*name == '\0') {
+        print_cold(sys->inolink, out, BINARY_FORMAT);
+        for (ino = sys->inolink->last; ino != NULL; ino = ino->prev)
+            write_inoculation(out, BINARY_FORMAT, ino->name, strlen(ino->name), ino->vaccine->batch, ino->date);
+        reply(out, STATUS_OK);
+        return;
+    }
+    find_hash(sys->user, name, strlen(name), &user);
+    if (user == NULL) {
+        reply(out, CODE_NO_USER);
+        return;
+    }
+    print_cold_user(sys->inolink, user, out, BINARY_FORMAT);
+    for (i = 0; i < user->count; i++) {
+        ino = RECORD(sys->inolink, user_inos(user)[i]);
+        write_inoculation(out, BINARY_FORMAT, user->name, user->size, ino->vaccine->batch, ino->date);
+    }
+    reply(out, STATUS_OK);
+}
+
+
+/**
+ * @brief Moves the present date forward, as `t` does.
+ */
+static void binary_time(Sys *sys, Request *request, FILE *out) {
+    Date date = get_date(request);
+
+    if (request->short_frame) {
+        reply(out, CODE_INV_FRAME);
+        return;
+    }
+    if (check_inv_date(date, sys->present) != VALID) {
+        reply(out, CODE_INV_DATE);
+        return;
+    }
+    advance_date(sys, date);
+    put_number(out, 1 + DATE_BYTES, LENGTH_BYTES);
+    put_number(out, STATUS_OK, 1);
+    put_date(out, sys->present);
+}
+
+
+void serve_binary(Sys *sys, FILE *in, FILE *out) {
+    int opcode;
+    Request request;
+
+    request.data = NULL;
+    request.texts = NULL;
+    request.capacity = START;
+    while (read_request(in, &request)) {
+        opcode = (int) get_number(&request, 1);
+        if (sys->journal.source != NULL) {      /* A follower first applies what the primary wrote */
+            catch_up(sys);
+            if (opcode != '\0' && strchr(WRITE_COMMANDS, opcode) != NULL) {
+                reply(out, CODE_READ_ONLY);
+                fflush(out);
+                continue;
+            }
+        }
+        if (opcode == OP_QUIT) {
+            reply(out, STATUS_OK);
+            break;
+        }
+        switch (opcode) {
+            case OP_CREATE: binary_create(sys, &request, out); break;
+            case OP_LIST: binary_list(sys, &request, out); break;
+            case OP_APPLY: binary_apply(sys, &request, out); break;
+            case OP_REMOVE: binary_remove(sys, &request, out); break;
+            case OP_DELETE: binary_delete(sys, &request, out); break;
+            case OP_USER: binary_user(sys, &request, out); break;
+            case OP_TIME: binary_time(sys, &request, out); break;
+            default: reply(out, CODE_INV_FRAME); break;
+        }
+        fflush(out);        /* The client waits for the whole response */
+    }
+    fflush(out);
+    free(request.data);
+    free(request.texts);
+}
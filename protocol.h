@@ -0,0 +1,108 @@
+/**
+ * @file protocol.h
+ * @brief Header file for the binary protocol used by programs instead of the text commands.
+ *
+ * After the text command `B`, stdin carries requests and stdout responses as
+ * frames: a 4-byte length, then that many bytes. A request holds an opcode,
+ * the letter of the text command it replaces, and its packed arguments. A
+ * response holds a status and its packed values: each row of a listing is a
+ * ROW_STATUS frame, and every request ends with one frame whose status is
+ * STATUS_OK or an error code. Numbers are little-endian, texts a 2-byte
+ * length and their bytes, dates a byte for the day, one for the month and two
+ * for the year. Nothing is formatted, localized or parsed as text.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+
+#define OP_CREATE       'c'     /**< Text batch, date expiry, int doses, text vaccine; answers the batch */
+#define OP_LIST         'l'     /**< Text vaccine (empty for all); rows of vaccine, batch, expiry, doses, uses */
+#define OP_APPLY        'a'     /**< Text user, text vaccine; answers the batch */
+#define OP_REMOVE       'r'     /**< Text batch; answers int uses */
+#define OP_DELETE       'd'     /**< Text user, byte mode, date, text batch; answers int count */
+#define OP_USER         'u'     /**< Text user (empty for all); rows of user, batch, date */
+#define OP_TIME         't'     /**< Date; answers the date */
+#define OP_QUIT         'q'     /**< Ends the program */
+
+#define STATUS_OK       0       /**< Status of a request that succeeded */
+#define CODE_DUP_BATCH  1       /**< Error status: duplicate batch (NUM_DUP_BATCH) */
+#define CODE_INV_BATCH  2       /**< Error status: invalid batch (NUM_INV_BATCH) */
+#define CODE_INV_NAME   3       /**< Error status: invalid vaccine name (NUM_INV_NAME) */
+#define CODE_INV_DATE   4       /**< Error status: invalid date (NUM_INV_DATE) */
+#define CODE_INV_QTY    5       /**< Error status: invalid quantity (NUM_INV_QNT) */
+#define CODE_TOO_MANY   6       /**< Error status: too many vaccines (NUM_TOO_MANY) */
+#define CODE_NO_STOCK   7       /**< Error status: no stock (NUM_NO_STOCK) */
+#define CODE_ALREADY    8       /**< Error status: already vaccinated (NUM_ALREADY) */
+#define CODE_NO_VAC     9       /**< Error status: no such vaccine */
+#define CODE_NO_BATCH   10      /**< Error status: no such batch */
+#define CODE_NO_USER    11      /**< Error status: no such user */
+#define CODE_READ_ONLY  12      /**< Error status: change sent to a follower */
+#define CODE_INV_FRAME  13      /**< Error status: unknown opcode or arguments cut short */
+#define ROW_STATUS      255     /**< Status of a row of a listing */
+
+#define LENGTH_BYTES    4       /**< Bytes of the length of a frame */
+#define MAX_FRAME       65536   /**< Longest payload of a request; longer ones are answered with CODE_INV_FRAME */
+#define TEXT_BYTES      2       /**< Bytes of the length of a text */
+#define DATE_BYTES      4       /**< Bytes of a date */
+#define INT_BYTES       4       /**< Bytes of a number */
+
+#define NO_DATE         "00-00-0"   /**< Invalid date given to `d` when the one sent does not fit */
+
+#define INV_MODE(A) ((A == ENG) ? "invalid mode" : "modo inválido") /**< Error message: binary mode with a read-ahead window */
+
+
+struct system;
+
+
+/**
+ * @brief Writes a little-endian number.
+ *
+ * @param out Output stream.
+ * @param value The number.
+ * @param bytes Number of bytes.
+ */
+void put_number(FILE *out, unsigned long value, int bytes);
+
+
+/**
+ * @brief Writes a text as its length and its bytes.
+ *
+ * @param out Output stream.
+ * @param text The text (not necessarily null-terminated).
+ * @param size Length of the text.
+ */
+void put_text(FILE *out, char *text, int size);
+
+
+/**
+ * @brief Writes a date as its day, month and year.
+ *
+ * @param out Output stream.
+ * @param date The date.
+ */
+void put_date(FILE *out, Date date);
+
+
+/**
+ * @brief Answers requests until the quit opcode or the end of the input.
+ *
+ * Changes are journaled as their text commands would be, and a follower
+ * rejects them with CODE_READ_ONLY.
+ *
+ * @param sys Pointer to the system structure.
+ * @param in Input stream of the requests.
+ * @param out Output stream of the responses.
+ */
+void serve_binary(struct system *sys, FILE *in, FILE *out);
+
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file ranking.c
+ * @brief Implements the selection of the k best items of a listing.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ranking.h"
+
+
+void start_ranking(Ranking *ranking, int k) {
+    ranking->size = (k < NUM_RANKED) ? k : NUM_RANKED;
+    ranking->heap = malloc(sizeof(Ranked) * ranking->size);
+    ranking->count = 0;
+    ranking->k = k;
+    ranking->offered = 0;
+}
+
+
+void free_ranking(Ranking *ranking) {
+    free(ranking->heap);
+    ranking->heap = NULL;
+    ranking->count = ranking->size = 0;
+}
+
+
+/**
+ * @brief Tells if an item ranks below another.
+ */
+static int worse(Ranked *a, Ranked *b) {
+    return a->score < b->score || (a->score == b->score && a->pos > b->pos);
+}
+
+
+/**
+ * @brief Swaps two items.
+ */
+static void swap_ranked(Ranked *a, Ranked *b) {
+    Ranked aux = *a;
+    *a = *b;
+    *b = aux;
+}
+
+
+/**
+ * @brief Restores the heap order from a position down.
+ */
+static void sink(Ranked heap[], int count, int i) {
+    int child;
+    while ((child = 2 * i + 1) < count) {
+        if (child + 1 < count && worse(&heap[child + 1], &heap[child])) child++;
+        if (!worse(&heap[child], &heap[i])) break;
+        swap_ranked(&heap[i], &heap[child]);
+        i = child;
+    }
+}
+
+
+void rank_item(Ranking *ranking, void *item, int score) {
+    int i;
+    Ranked entry;
+
+    entry.item = item;
+    entry.score = score;
+    entry.pos = ranking->offered++;
+
+    if (ranking->count == ranking->k) {     /* Full: it replaces the worst one, if better */
+        if (!worse(&ranking->heap[0], &entry)) return;
+        ranking->heap[0] = entry;
+        sink(ranking->heap, ranking->count, 0);
+        return;
+    }
+    if (ranking->count == ranking->size) {
+        ranking->size = (ranking->size > ranking->k / 2) ? ranking->k : 2 * ranking->size;
+        ranking->heap = realloc(ranking->heap, sizeof(Ranked) * ranking->size);
+    }
+    i = ranking->count++;
+    ranking->heap[i] = entry;
+    while (i > 0 && worse(&ranking->heap[i], &ranking->heap[(i - 1) / 2])) {   /* Rises over the better ones */
+        swap_ranked(&ranking->heap[i], &ranking->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+}
+
+
+int finish_ranking(Ranking *ranking) {
+    int n;
+
+    for (n = ranking->count; n > 1; n--) {      /* Heap sort: the worst goes to the end */
+        swap_ranked(&ranking->heap[0], &ranking->heap[n - 1]);
+        sink(ranking->heap, n - 1, 0);
+    }
+    return ranking->count;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file ranking.h
+ * @brief Header file for the selection of the k best items of a listing.
+ *
+ * The items are offered one at a time and a heap keeps the k best seen so
+ * far, with the worst of them at the root, so a listing of n items is ranked
+ * in O(n log k) time and O(k) memory. Higher scores rank first and equal
+ * scores keep the order in which they were offered.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef RANKING_H
+#define RANKING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_RANKED  16      /**< Initial size of the heap of a ranking */
+
+
+/**
+ * @brief An item offered to a ranking.
+ */
+typedef struct {
+    void *item;             /**< The item */
+    int score;              /**< Its score */
+    long pos;               /**< Order in which it was offered, breaks ties */
+} Ranked;
+
+
+/**
+ * @brief The k best items offered so far.
+ */
+typedef struct {
+    Ranked *heap;           /**< Heap of the items kept, the worst one first */
+    int count;              /**< Number of items kept */
+    int size;               /**< Size of the heap, grown up to k */
+    int k;                  /**< Number of items to keep */
+    long offered;           /**< Number of items offered */
+} Ranking;
+
+
+/**
+ * @brief Starts an empty ranking.
+ *
+ * @param ranking Pointer to the ranking.
+ * @param k Number of items to keep (at least 1).
+ */
+void start_ranking(Ranking *ranking, int k);
+
+
+/**
+ * @brief Offers an item, kept if it is among the k best so far.
+ *
+ * @param ranking Pointer to the ranking.
+ * @param item The item.
+ * @param score Its score.
+ */
+void rank_item(Ranking *ranking, void *item, int score);
+
+
+/**
+ * @brief Sorts the items kept, best first.
+ *
+ * @param ranking Pointer to the ranking.
+ * @return Number of items, in ranking->heap.
+ */
+int finish_ranking(Ranking *ranking);
+
+
+/**
+ * @brief Frees the ranking.
+ *
+ * @param ranking Pointer to the ranking.
+ */
+void free_ranking(Ranking *ranking);
+
+
+#endif
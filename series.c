@@ -0,0 +1,110 @@
+/**
+ * @file series.c
+ * @brief Implements the daily time series of doses per vaccine.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "inoculation.h"
+#include "series.h"
+
+
+void start_series(Series *series) {
+    series->chunks = NULL;
+    series->num_chunks = START;
+}
+
+
+void free_series(Series *series) {
+    int i, c;
+    for (i = 0; i < series->num_chunks; i++) {
+        for (c = 0; c < NUM_COUNTERS; c++)
+            free(series->chunks[i].columns[c]);
+    }
+    free(series->chunks);
+    start_series(series);
+}
+
+
+/**
+ * @brief Finds the chunk of a day and the position of the day in it.
+ */
+static int day_chunk(int day, int *offset) {
+    Date date = day_to_date(day);
+
+    *offset = date.day - FIRST_DAY;
+    return (date.year - FIRST_YEAR) * LAST_MONTH + date.month - FIRST_MONTH;
+}
+
+
+/**
+ * @brief Makes room for a month and a vaccine column in it.
+ */
+static Month *grow_chunk(Series *series, int month, int name_id) {
+    int i, c, width, size = (series->num_chunks == 0) ? NUM_CHUNKS : series->num_chunks;
+    Month *chunk;
+
+    if (month >= series->num_chunks) {
+        while (size <= month) size *= 2;
+        series->chunks = realloc(series->chunks, sizeof(Month) * size);
+        for (i = series->num_chunks; i < size; i++) {
+            for (c = 0; c < NUM_COUNTERS; c++)
+                series->chunks[i].columns[c] = NULL;
+            series->chunks[i].width = START;
+        }
+        series->num_chunks = size;
+    }
+    chunk = &series->chunks[month];
+    if (name_id < chunk->width) return chunk;
+
+    width = (chunk->width == 0) ? NUM_SERIES_IDS : chunk->width;
+    while (width <= name_id) width *= 2;
+    for (c = 0; c < NUM_COUNTERS; c++) {        /* New columns go after the others, which stay in place */
+        chunk->columns[c] = realloc(chunk->columns[c], sizeof(int) * CHUNK_DAYS * width);
+        memset(chunk->columns[c] + CHUNK_DAYS * chunk->width, 0, sizeof(int) * CHUNK_DAYS * (width - chunk->width));
+    }
+    chunk->width = width;
+    return chunk;
+}
+
+
+void series_add(Series *series, int counter, int name_id, int day, int doses) {
+    int offset, month;
+    Month *chunk;
+
+    if (day < 0 || doses == 0) return;
+    month = day_chunk(day, &offset);
+    chunk = grow_chunk(series, month, name_id);
+    chunk->columns[counter][CHUNK_DAYS * name_id + offset] += doses;
+}
+
+
+int print_series(Series *series, int name_id, int first, int last) {
+    int day, offset, month, end, count = START, *administered, *expired;
+    int days_in_month[12] = DAYS_IN_MONTH;
+    Month *chunk;
+
+    for (day = (first < 0) ? 0 : first; day <= last; day = end) {
+        month = day_chunk(day, &offset);
+        end = day + days_in_month[month % LAST_MONTH] - offset;     /* First day of the next month */
+        if (month >= series->num_chunks) break;
+        chunk = &series->chunks[month];
+        if (name_id >= chunk->width) continue;          /* Nothing that month */
+
+        administered = chunk->columns[ADMINISTERED] + CHUNK_DAYS * name_id;
+        expired = chunk->columns[EXPIRED] + CHUNK_DAYS * name_id;
+        for (; day < end && day <= last; day++, offset++) {
+            if (administered[offset] == 0 && expired[offset] == 0) continue;
+            print_date(day_to_date(day));
+            printf(",%d,%d\n", administered[offset], expired[offset]);
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file series.h
+ * @brief Header file for the daily time series of doses per vaccine.
+ *
+ * Each counter is a dense matrix of days by vaccine name id, cut into one
+ * chunk per month. Inside a chunk every vaccine has a column of its days, so
+ * a range of one vaccine reads consecutive integers and a month without
+ * events costs no memory. The history adds the doses administered and takes
+ * away those deleted by `d`; `t` adds the doses left in the batches that
+ * expire, on their expiry day. A retention purge keeps the counts.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef SERIES_H
+#define SERIES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+
+#define ADMINISTERED    0       /**< Counter of the doses administered */
+#define EXPIRED         1       /**< Counter of the doses expired */
+#define NUM_COUNTERS    2       /**< Number of counters of a day */
+#define CHUNK_DAYS      31      /**< Days of a chunk, the longest month */
+#define NUM_CHUNKS      12      /**< Initial number of chunks */
+#define NUM_SERIES_IDS  8       /**< Initial number of vaccine columns of a chunk */
+
+
+/**
+ * @brief Counters of one month.
+ */
+typedef struct {
+    int *columns[NUM_COUNTERS]; /**< CHUNK_DAYS days per vaccine name id, for each counter */
+    int width;                  /**< Number of vaccine columns */
+} Month;
+
+
+/**
+ * @brief Counters of every day and vaccine, by month.
+ */
+typedef struct {
+    Month *chunks;              /**< Chunks by month since the first one, empty until used */
+    int num_chunks;             /**< Size of the table of chunks */
+} Series;
+
+
+/**
+ * @brief Initializes an empty series.
+ *
+ * @param series Pointer to the series.
+ */
+void start_series(Series *series);
+
+
+/**
+ * @brief Frees the series.
+ *
+ * @param series Pointer to the series.
+ */
+void free_series(Series *series);
+
+
+/**
+ * @brief Adds to a counter of a day and vaccine.
+ *
+ * @param series Pointer to the series.
+ * @param counter ADMINISTERED or EXPIRED.
+ * @param name_id Id of the vaccine name.
+ * @param day Day number.
+ * @param doses Doses to add, negative to take away.
+ */
+void series_add(Series *series, int counter, int name_id, int day, int doses);
+
+
+/**
+ * @brief Prints the days of a range with any dose of a vaccine, one CSV row each.
+ *
+ * @param series Pointer to the series.
+ * @param name_id Id of the vaccine name.
+ * @param first First day number.
+ * @param last Last day number.
+ * @return Number of rows printed.
+ */
+int print_series(Series *series, int name_id, int first, int last);
+
+
+#endif
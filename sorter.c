@@ -0,0 +1,296 @@
+/**
+ * @file sorter.c
+ * @brief Implements the sorted listing with an external merge sort.
+ *
+ * The log is read once, oldest record first, from the cold segments and then
+ * from the inoculation list. Runs are merged MERGE_WAYS at a time through a
+ * binary heap until the last merge, which prints the rows. When exporting,
+ * a user row goes before the first row of each name.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+#include "inoculation.h"
+#include "user.h"
+#include "catalog.h"
+#include "cold.h"
+#include "system.h"
+#include "export.h"
+#include "sorter.h"
+
+
+#define ROW_TEXT(R)  ((R)->name_off + (R)->name_size)    /**< Length of the text of row R */
+#define ROW_BYTES(R) (sizeof(SortRow) + ROW_TEXT(R))     /**< Bytes of row R in a run */
+#define SLOTS(S)     ((SortRow**) ((S)->memory + (S)->budget) - (S)->count)   /**< Pointers to the rows of sort S */
+
+
+/**
+ * @brief Compares two rows by key and then by position in the log.
+ */
+static int comp_row(const SortRow *row1, const SortRow *row2) {
+    int size = (row1->key_size < row2->key_size) ? row1->key_size : row2->key_size;
+    int result = memcmp(row1->text, row2->text, size);
+
+    if (result != 0) return result;
+    if (row1->key_size != row2->key_size) return row1->key_size - row2->key_size;
+    return (row1->seq > row2->seq) - (row1->seq < row2->seq);
+}
+
+
+/**
+ * @brief Compares two pointers to rows, for qsort.
+ */
+static int comp_slot(const void *a, const void *b) {
+    return comp_row(*(SortRow* const*) a, *(SortRow* const*) b);
+}
+
+
+/**
+ * @brief Adds a run to the table of runs.
+ */
+static void push_run(Sorter *sorter, FILE *run) {
+    if (sorter->num_runs == sorter->runs_size) {
+        sorter->runs_size *= 2;
+        sorter->runs = realloc(sorter->runs, sizeof(FILE*) * sorter->runs_size);
+    }
+    sorter->runs[sorter->num_runs++] = run;
+}
+
+
+/**
+ * @brief Sorts the rows in memory and writes them to a new run.
+ */
+static void flush_run(Sorter *sorter) {
+    int i;
+    SortRow **slots = SLOTS(sorter);
+    FILE *run = tmpfile();
+
+    qsort(slots, sorter->count, sizeof(SortRow*), comp_slot);
+    for (i = 0; i < sorter->count; i++)
+        fwrite(slots[i], ROW_BYTES(slots[i]), 1, run);
+    rewind(run);
+    push_run(sorter, run);
+    sorter->used = START;
+    sorter->count = START;
+}
+
+
+/**
+ * @brief Adds an inoculation to the sort, writing a run if the budget is full.
+ */
+static void add_row(Sorter *sorter, char *name, int size, char *vaccine, char *batch, int day) {
+    int key_size = (sorter->order == SORT_BY_VACCINE) ? strlen(vaccine) : 0;
+    long bytes = (sizeof(SortRow) + key_size + size + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN;
+    SortRow *row;
+
+    if (sorter->used + bytes + (long) sizeof(SortRow*) * (sorter->count + 1) > sorter->budget)
+        flush_run(sorter);
+
+    row = (SortRow*) (sorter->memory + sorter->used);
+    sorter->used += bytes;
+    sorter->count++;
+    SLOTS(sorter)[0] = row;
+
+    row->seq = sorter->seq++;
+    row->day = day;
+    row->name_off = key_size;
+    row->name_size = size;
+    row->key_size = (sorter->order == SORT_BY_VACCINE) ? key_size : size;
+    strcpy(row->batch, batch);
+    memcpy(row->text, vaccine, key_size);
+    memcpy(row->text + key_size, name, size);
+}
+
+
+/**
+ * @brief Reads the next row of a run.
+ *
+ * @param row Pointer to the row buffer, grown when needed.
+ * @param size Pointer to the size of the row buffer.
+ * @return VALID, or INVALID at the end of the run.
+ */
+static int read_row(FILE *run, SortRow **row, long *size) {
+    SortRow header;
+
+    if (fread(&header, sizeof(SortRow), 1, run) != 1) return INVALID;
+    if ((long) ROW_BYTES(&header) > *size) {
+        *size = ROW_BYTES(&header);
+        *row = realloc(*row, *size);
+    }
+    memcpy(*row, &header, sizeof(SortRow));     /* Same bytes as the row in memory */
+    fread((char*) *row + sizeof(SortRow), 1, ROW_TEXT(&header), run);
+    return VALID;
+}
+
+
+/**
+ * @brief Writes a row in the format of the sort, after its user when it is the first of a name.
+ */
+static void print_row(Sorter *sorter, SortRow *row) {
+    char *name = row->text + row->name_off;
+    User *user;
+
+    if (sorter->sys != NULL && (row->name_size != sorter->last_size || memcmp(name, sorter->last, row->name_size) != 0)) {
+        find_hash(sorter->sys->user, name, row->name_size, &user);
+        write_user(sorter->out, sorter->format, user);
+        sorter->rows++;
+        if (row->name_size > sorter->last_room) {
+            sorter->last_room = row->name_size;
+            sorter->last = realloc(sorter->last, sorter->last_room);
+        }
+        memcpy(sorter->last, name, row->name_size);
+        sorter->last_size = row->name_size;
+    }
+    write_inoculation(sorter->out, sorter->format, name, row->name_size, row->batch, day_to_date(row->day));
+    sorter->rows++;
+}
+
+
+/**
+ * @brief Restores the heap order from a position down.
+ */
+static void fix_down(int heap[], int count, SortRow *heads[], int i) {
+    int child;
+    while ((child = 2 * i + 1) < count) {
+        if (child + 1 < count && comp_row(heads[heap[child + 1]], heads[heap[child]]) < 0) child++;
+        if (comp_row(heads[heap[i]], heads[heap[child]]) <= 0) break;
+        exch(&heap[i], &heap[child]);
+        i = child;
+    }
+}
+
+
+/**
+ * @brief Merges some runs, into a new run or to the output.
+ *
+ * @param sorter Pointer to the sort.
+ * @param runs The runs to merge, closed at the end.
+ * @param n Number of runs.
+ * @param out Run that receives the rows, or NULL to print them.
+ */
+static void merge_runs(Sorter *sorter, FILE *runs[], int n, FILE *out) {
+    int i, count = START, *heap = malloc(sizeof(int) * n);
+    SortRow **heads = malloc(sizeof(SortRow*) * n);
+    long *sizes = malloc(sizeof(long) * n);
+
+    for (i = 0; i < n; i++) {
+        sizes[i] = sizeof(SortRow) + NAME_SIZE;
+        heads[i] = malloc(sizes[i]);
+        if (read_row(runs[i], &heads[i], &sizes[i]) == VALID) heap[count++] = i;
+    }
+    for (i = count / 2 - 1; i >= 0; i--)
+        fix_down(heap, count, heads, i);
+
+    while (count > 0) {
+        i = heap[0];
+        if (out != NULL) fwrite(heads[i], ROW_BYTES(heads[i]), 1, out);
+        else print_row(sorter, heads[i]);
+        if (read_row(runs[i], &heads[i], &sizes[i]) != VALID) heap[0] = heap[--count];
+        fix_down(heap, count, heads, 0);
+    }
+
+    for (i = 0; i < n; i++) {
+        fclose(runs[i]);
+        free(heads[i]);
+    }
+    free(heap); free(heads); free(sizes);
+}
+
+
+/**
+ * @brief Prints the rows, from memory or by merging the runs.
+ */
+static void finish_sort(Sorter *sorter) {
+    int i;
+    SortRow **slots;
+    FILE *run;
+
+    if (sorter->num_runs == 0) {        /* Everything fit in the budget */
+        slots = SLOTS(sorter);
+        qsort(slots, sorter->count, sizeof(SortRow*), comp_slot);
+        for (i = 0; i < sorter->count; i++)
+            print_row(sorter, slots[i]);
+        return;
+    }
+    if (sorter->count > 0) flush_run(sorter);
+
+    while (sorter->num_runs > MERGE_WAYS) {     /* Merge passes until one merge is left */
+        run = tmpfile();
+        merge_runs(sorter, sorter->runs, MERGE_WAYS, run);
+        rewind(run);
+        memmove(sorter->runs, sorter->runs + MERGE_WAYS, sizeof(FILE*) * (sorter->num_runs - MERGE_WAYS));
+        sorter->num_runs -= MERGE_WAYS;
+        push_run(sorter, run);
+    }
+    merge_runs(sorter, sorter->runs, sorter->num_runs, NULL);
+}
+
+
+/**
+ * @brief Sorts every inoculation, including the cold tier, and writes the rows.
+ *
+ * @return Number of rows written.
+ */
+static int run_sort(Sys *sys, int order, long budget, FILE *out, int format, Sys *users) {
+    int i, j, size;
+    char *name;
+    Sorter sorter;
+    Segment *segment;
+    ColdRecord records[COLD_CHUNK];
+    LinkInl ino;
+
+    sorter.out = out;
+    sorter.format = format;
+    sorter.sys = users;
+    sorter.last = NULL;
+    sorter.last_size = -1;
+    sorter.last_room = START;
+    sorter.rows = START;
+    sorter.order = order;
+    sorter.budget = budget / ROW_ALIGN * ROW_ALIGN;
+    sorter.memory = malloc(sorter.budget);
+    sorter.used = START;
+    sorter.count = START;
+    sorter.seq = START;
+    sorter.num_runs = START;
+    sorter.runs_size = NUM_RUNS;
+    sorter.runs = malloc(sizeof(FILE*) * NUM_RUNS);
+
+    for (segment = sys->inolink->segments; segment != NULL; segment = segment->next) {
+        for (i = 0; i < segment->count; i += size) {
+            size = read_records(segment, i, records);
+            for (j = 0; j < size; j++) {
+                if (IS_DELETED(segment, i + j)) continue;
+                name = read_name(segment, &records[j]);
+                add_row(&sorter, name, records[j].size, sys->catalog.names[records[j].vaccine],
+                        records[j].batch, records[j].day);
+                free(name);
+            }
+        }
+    }
+    for (ino = sys->inolink->last; ino != NULL; ino = ino->prev)
+        add_row(&sorter, ino->name, strlen(ino->name), ino->vaccine->name, ino->vaccine->batch, date_to_day(ino->date));
+
+    finish_sort(&sorter);
+    free(sorter.memory);
+    free(sorter.runs);
+    free(sorter.last);
+    return sorter.rows;
+}
+
+
+void sorted_listing(Sys *sys, int order, long budget) {
+    run_sort(sys, order, budget, stdout, TEXT_FORMAT, NULL);
+}
+
+
+int sorted_export(Sys *sys, FILE *out, int format, long budget) {
+    return run_sort(sys, SORT_BY_USER, budget, out, format, sys);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file sorter.h
+ * @brief Header file for the sorted listing of every inoculation.
+ *
+ * Declares an external merge sort with a fixed memory budget. Rows are
+ * gathered in one block of memory; when it is full they are sorted and
+ * written to a temporary file (a run), and the runs are merged at the end.
+ * When every row fits in the budget the listing is sorted in memory only.
+ * The export ordered by user goes through the same sort.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#ifndef SORTER_H
+#define SORTER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "date.h"
+#include "vaccine.h"
+
+#define SORT_BY_USER    0           /**< Rows ordered by user name */
+#define SORT_BY_VACCINE 1           /**< Rows ordered by vaccine name */
+
+#define SORT_BUDGET     (1L << 24)  /**< Default memory budget of a sort, in bytes */
+#define SORT_MIN        (1L << 17)  /**< Smallest budget, enough for the longest row */
+#define ROW_ALIGN       8           /**< Alignment of the rows in the sort memory */
+#define MERGE_WAYS      16          /**< Runs merged at a time */
+#define NUM_RUNS        16          /**< Initial size of the table of runs */
+
+#define INV_ORDER(A) ((A == ENG) ? "invalid order" : "ordem inválida") /**< Error message: unknown sort order */
+
+
+/**
+ * @brief One inoculation to be sorted.
+ *
+ * The text holds the sort key followed by the user name; when the key is
+ * the user name it is stored once.
+ */
+typedef struct {
+    long seq;               /**< Position of the record in the log, breaks ties */
+    int day;                /**< Day number of the inoculation */
+    int key_size;           /**< Length of the sort key */
+    int name_off;           /**< Offset of the user name in the text */
+    int name_size;          /**< Length of the user name */
+    char batch[BATCH_SIZE]; /**< Batch code */
+    char text[];            /**< Sort key and user name */
+} SortRow;
+
+
+/**
+ * @brief State of a sort.
+ *
+ * Rows grow from the start of the memory block and the table of pointers to
+ * them grows down from its end, so both share the budget.
+ */
+typedef struct {
+    int order;              /**< SORT_BY_USER or SORT_BY_VACCINE */
+    char *memory;           /**< Memory block of the budget */
+    long budget;            /**< Size of the memory block */
+    long used;              /**< Bytes taken by the rows */
+    int count;              /**< Number of rows in memory */
+    long seq;               /**< Number of rows added */
+    FILE **runs;            /**< Sorted runs written to temporary files */
+    int num_runs;           /**< Number of runs */
+    int runs_size;          /**< Size of the table of runs */
+    FILE *out;              /**< Output stream of the rows */
+    int format;             /**< Format of the rows, one of export.h */
+    struct system *sys;     /**< System whose users are written before their rows, or NULL */
+    char *last;             /**< Name of the last user written */
+    int last_size;          /**< Length of that name, -1 before the first */
+    long last_room;         /**< Size of the buffer of that name */
+    int rows;               /**< Number of rows written */
+} Sorter;
+
+
+struct system;
+
+
+/**
+ * @brief Prints every inoculation, including the cold tier, sorted by user or by vaccine.
+ *
+ * Inoculations with the same key keep their date order. Each row has the
+ * format of `u`.
+ *
+ * @param sys Pointer to the system structure.
+ * @param order SORT_BY_USER or SORT_BY_VACCINE.
+ * @param budget Memory budget in bytes (at least SORT_MIN).
+ */
+void sorted_listing(struct system *sys, int order, long budget);
+
+
+/**
+ * @brief Writes every user, ordered by name, each followed by its inoculations in date order.
+ *
+ * @param sys Pointer to the system structure.
+ * @param out Output file.
+ * @param format CSV_FORMAT or JSONL_FORMAT.
+ * @param budget Memory budget in bytes (at least SORT_MIN).
+ * @return Number of rows written.
+ */
+int sorted_export(struct system *sys, FILE *out, int format, long budget);
+
+
+#endif
@@ -23,6 +23,11 @@
 #include "vaccine.h"
 #include "inoculation.h"
 #include "user.h"
+#include "catalog.h"
+#include "cold.h"
+#include "journal.h"
+#include "board.h"
+#include "history.h"
 #include "system.h"
 
 
@@ -33,6 +38,16 @@ void start_sys(Sys *sys, int arg1) {
     sys->inolink = malloc(sizeof(Ino));
     sys->inolink->head = NULL;
     sys->inolink->last = NULL;
+    sys->inolink->num_days = NUM_DAYS;
+    sys->inolink->days = calloc(NUM_DAYS, sizeof(DayBucket));
+    sys->inolink->num_blocks = NUM_BLOCKS;
+    sys->inolink->blocks = malloc(sizeof(LinkInl) * NUM_BLOCKS);
+    sys->inolink->used = START;
+    sys->inolink->seq = START;
+    sys->inolink->free = NULL;
+    sys->inolink->segments = NULL;
+    sys->inolink->horizon = START;
+    sys->inolink->cutoff = START;
 
 
 
@@ -40,8 +55,17 @@ void start_sys(Sys *sys, int arg1) {
     sys->user->count = START;
     sys->user->size = NUM_USERS;
     sys->user->user_list = calloc(NUM_USERS, sizeof(User*));
+    sys->user->names.chunks = NULL;
+    sys->user->hint = NULL;
 
     sys->entries = START;
+    start_catalog(&sys->catalog);
+    start_cache(&sys->cache);
+    start_journal(&sys->journal);
+    start_board(&sys->board);
+    start_history(&sys->history);
+    start_executor(&sys->executor);
+    start_archive(&sys->archive);
 
 
     sys->present.day = FIRST_DAY;
@@ -50,6 +74,144 @@ void start_sys(Sys *sys, int arg1) {
 }
 
 
+int insert_batch(Sys *sys, Vaccine *batch) {
+    int i = add_batch(sys->batch_list, batch, sys->entries);
+
+    catalog_insert(&sys->catalog, i, sys->entries, batch);
+    history_batch(&sys->history, &sys->catalog, batch, date_to_day(sys->present));
+    invalidate_name(&sys->cache, sys->catalog.name_id[i]);
+    (sys->entries)++;
+    publish_all(&sys->board, sys->batch_list, sys->entries);
+    return i;
+}
+
+
+LinkInl apply_dose(Sys *sys, int k, char *name, int size, Date date) {
+    LinkInl record = new_record(sys->inolink);
+
+    record->date = date;
+    record->vaccine = sys->batch_list[k];
+    insert_hash(sys->user, sys->inolink, record, name, size);
+    add_inoculation(sys->inolink, record);
+    history_apply(&sys->history, record, size);
+    sys->catalog.dose[k] = record->vaccine->dose;
+    invalidate_name(&sys->cache, sys->catalog.name_id[k]);
+    publish_batch(&sys->board, record->vaccine, k);
+    return record;
+}
+
+
+int delete_applications(Sys *sys, char *name, int size, char *date, char *batch, int check) {
+    int result = remove_application(sys->inolink, sys->user, sys->present,
+            name, size, date, batch, check);
+    Date day;
+
+    if (result <= 0) return result;
+    if (check == ONLY_NAME)
+        history_delete(&sys->history, name, size, ALL_DAYS, NULL, date_to_day(sys->present));
+    else if (parse_date(date, &day) == VALID && past_date(day, sys->present) <= 0)     /* Not a rejected date */
+        history_delete(&sys->history, name, size, date_to_day(day), check == WITH_BATCH ? batch : NULL,
+                date_to_day(sys->present));
+    return result;
+}
+
+
+int purge_applications(Sys *sys, Date cutoff) {
+    int count = purge(sys->inolink, sys->user, date_to_day(cutoff));
+
+    history_purge(&sys->history, date_to_day(cutoff));
+    return count;
+}
+
+
+int withdraw_batch(Sys *sys, int i) {
+    int uses = sys->batch_list[i]->uses;
+
+    invalidate_name(&sys->cache, sys->catalog.name_id[i]);
+    history_withdraw(&sys->history, sys->batch_list[i], uses == 0, date_to_day(sys->present));
+    if (uses == 0) {
+        catalog_remove(&sys->catalog, i, sys->entries);
+        remove_batch(sys->batch_list, &sys->entries, i);
+    }
+    else {
+        sys->batch_list[i]->dose = 0;
+        sys->catalog.dose[i] = 0;
+    }
+    publish_all(&sys->board, sys->batch_list, sys->entries);
+    return uses;
+}
+
+
+void archive_batch(Sys *sys, int i) {
+    Vaccine *vaccine = sys->batch_list[i];
+
+    invalidate_name(&sys->cache, sys->catalog.name_id[i]);
+    history_withdraw(&sys->history, vaccine, 1, date_to_day(sys->present));
+    catalog_remove(&sys->catalog, i, sys->entries);
+    sys->entries--;
+    memmove(sys->batch_list + i, sys->batch_list + i + 1, sizeof(Vaccine*) * (sys->entries - i));
+    archive_add(&sys->archive, vaccine);
+    publish_all(&sys->board, sys->batch_list, sys->entries);
+}
+
+
+void advance_date(Sys *sys, Date date) {
+    journal_date(&sys->journal, date);
+    move_date(sys, date);
+}
+
+
+void move_date(Sys *sys, Date date) {
+    int from = date_to_day(sys->present);
+
+    sys->present = date;
+    expire_doses(sys, from);
+    if (sys->inolink->horizon > 0) {   /* Moves the records and their versions past the horizon out of memory */
+        spill(sys->inolink, sys->user, &sys->catalog, date_to_day(sys->present) - sys->inolink->horizon);
+        history_spill(&sys->history, sys->inolink->cutoff);
+    }
+    if (sys->archive.reclaim)
+        reclaim_batches(sys);
+}
+
+
+void expire_doses(Sys *sys, int from) {
+    int n, today = date_to_day(sys->present);
+
+    for (n = 0; n < sys->entries && sys->catalog.expiry[n] <= today; n++) {    /* The list is in expiry order */
+        if (sys->catalog.expiry[n] > from)
+            series_add(&sys->history.series, EXPIRED, sys->catalog.name_id[n], sys->catalog.expiry[n],
+                    sys->catalog.dose[n]);
+    }
+}
+
+
+int reclaim_batches(Sys *sys) {
+    int n, today = date_to_day(sys->present);
+    Vaccine *vaccine;
+
+    for (n = 0; n < sys->entries && sys->catalog.expiry[n] <= today; n++) {    /* The list is in expiry order */
+        vaccine = sys->batch_list[n];
+        invalidate_name(&sys->cache, sys->catalog.name_id[n]);
+        history_withdraw(&sys->history, vaccine, 1, today);
+        if (vaccine->uses == 0) {
+            journal_withdraw(&sys->journal, vaccine->batch);
+            free_vaccine(vaccine);
+        }
+        else {
+            journal_archive(&sys->journal, vaccine->batch);
+            archive_add(&sys->archive, vaccine);
+        }
+    }
+    if (n == 0) return 0;
+    sys->entries -= n;
+    memmove(sys->batch_list, sys->batch_list + n, sizeof(Vaccine*) * sys->entries);
+    catalog_build(&sys->catalog, sys->batch_list, sys->entries);
+    publish_all(&sys->board, sys->batch_list, sys->entries);
+    return n;
+}
+
+
 void exch(int *A, int *B) {
     int temp = *A;
     *A = *B;
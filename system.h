@@ -25,6 +25,14 @@
 #include "vaccine.h"
 #include "inoculation.h"
 #include "user.h"
+#include "catalog.h"
+#include "cold.h"
+#include "cache.h"
+#include "journal.h"
+#include "board.h"
+#include "history.h"
+#include "executor.h"
+#include "archive.h"
 
 #define START   0         /**< Starting index or default value used for counters and initializations. */
 #define MAXBUF  65536     /**< Maximum buffer size for reading input data. */
@@ -39,6 +47,9 @@
 #define NO_STOCK(A)         ((A == ENG) ? "no stock" : "esgotado") /**< Error: no available doses */
 #define NO_BATCH_FOUND(A)   ((A == ENG) ? ": no such batch" : ": lote inexistente") /**< Error: batch not found */
 #define ALREADY(A)          ((A == ENG) ? "already vaccinated" : "já vacinado") /**< Error: vaccine already applied */
+#define INV_CURSOR(A)       ((A == ENG) ? "invalid cursor" : "cursor inválido") /**< Error: malformed page cursor */
+#define NEXT_PAGE           "next"  /**< Prefix of the cursor printed after a full page */
+#define TOP_PAGE            "top"   /**< Cursor of `p` that asks for the k best rows instead of a page */
 
 /**
  * @struct Sys
@@ -48,8 +59,15 @@ typedef struct system {
     Date present;                          /**< Current system date. */
     int entries;                           /**< Number of vaccine batches currently registered. */
     Vaccine *batch_list[MAX_BRATCH];       /**< Array of pointers to vaccine batch records. */
+    Catalog catalog;                       /**< Column-oriented copy of the batch list used by scans. */
+    ListCache cache;                       /**< Rendered text of the l listings. */
     Ino *inolink;                          /**< Pointer to structure managing the linked list of inoculations. */
     HashTable *user;                       /**< Pointer to hash table storing user records and their inoculations. */
+    Journal journal;                       /**< Replication journal, written as primary or read as follower. */
+    Board board;                           /**< Catalog published for other processes. */
+    History history;                       /**< Versions of the batches and applications, for as-of queries. */
+    Executor executor;                     /**< Commands read ahead of their execution. */
+    Archive archive;                       /**< Expired batches taken out of the batch list. */
     int language;                          /**< Language setting (e.g., 0 for PT, 1 for ENG). */
 } Sys;
 
@@ -67,6 +85,118 @@ typedef struct system {
 void start_sys(Sys *sys, int arg1);
 
 
+/**
+ * @brief Adds a new batch to the batch list and to the catalog.
+ *
+ * @param sys Pointer to the system structure.
+ * @param batch The batch, with no uses yet.
+ * @return Position of the batch in the batch list.
+ */
+int insert_batch(Sys *sys, Vaccine *batch);
+
+
+/**
+ * @brief Applies a dose of a batch to a user on a date.
+ *
+ * @param sys Pointer to the system structure.
+ * @param k Position of the batch in the batch list.
+ * @param name User name.
+ * @param size Length of the user name.
+ * @param date Date of the inoculation.
+ * @return The new inoculation record.
+ */
+LinkInl apply_dose(Sys *sys, int k, char *name, int size, Date date);
+
+
+/**
+ * @brief Deletes applications of a user, as the d command does.
+ *
+ * @param sys Pointer to the system structure.
+ * @param name User name.
+ * @param size Length of the user name.
+ * @param date Date of the applications (used from WITH_DATE on).
+ * @param batch Batch code (used with WITH_BATCH).
+ * @param check Removal mode, as in remove_application.
+ * @return The result of remove_application.
+ */
+int delete_applications(Sys *sys, char *name, int size, char *date, char *batch, int check);
+
+
+/**
+ * @brief Deletes every application made before a date, as the z command does.
+ *
+ * @param sys Pointer to the system structure.
+ * @param cutoff First date that is kept.
+ * @return Number of applications deleted.
+ */
+int purge_applications(Sys *sys, Date cutoff);
+
+
+/**
+ * @brief Removes a batch, or only its remaining doses if it was already used.
+ *
+ * @param sys Pointer to the system structure.
+ * @param i Position of the batch in the batch list.
+ * @return Number of doses already used from the batch.
+ */
+int withdraw_batch(Sys *sys, int i);
+
+
+/**
+ * @brief Moves a used batch from the batch list to the archive.
+ *
+ * @param sys Pointer to the system structure.
+ * @param i Position of the batch in the batch list.
+ */
+void archive_batch(Sys *sys, int i);
+
+
+/**
+ * @brief Moves the present date forward, as `t` does.
+ *
+ * Journals the date, counts the doses that expired, moves the records past
+ * the horizon to the cold tier and, when reclamation is on, takes the
+ * expired batches out of the batch list.
+ *
+ * @param sys Pointer to the system structure.
+ * @param date The new date, already validated.
+ */
+void advance_date(Sys *sys, Date date);
+
+
+/**
+ * @brief Moves the present date forward without journaling it.
+ *
+ * Does all that advance_date does but write the date entry; a follower uses
+ * it to apply the dates of the primary.
+ *
+ * @param sys Pointer to the system structure.
+ * @param date The new date, already validated.
+ */
+void move_date(Sys *sys, Date date);
+
+
+/**
+ * @brief Counts the doses left in the batches that expired since a day.
+ *
+ * @param sys Pointer to the system structure.
+ * @param from Day number of the previous date; batches expiring after it and
+ * up to the current date are counted, on their expiry day.
+ */
+void expire_doses(Sys *sys, int from);
+
+
+/**
+ * @brief Takes the expired batches out of the batch list, as `t` does when reclamation is on.
+ *
+ * Batches never used are freed, the others archived; each one is journaled.
+ *
+ * @param sys Pointer to the system structure.
+ * @return Number of batches taken out.
+ */
+int reclaim_batches(Sys *sys);
+
+
 /**
  * @brief Exchanges the values of two integers.
  *
@@ -0,0 +1,144 @@
+/**
+ * @file bench_catalog.c
+ * @brief Times the batch scans of `a` and of the filtered `l` on the catalog columns and on the batch list.
+ *
+ * Fills a full batch list (1000 batches of 20 vaccines, about half of them
+ * expired or empty) and answers the same random vaccine names twice: with
+ * the search_vaccine loop over the batch list that `a` and `l` used before,
+ * and with catalog_first_eligible and catalog_select over the columns of the
+ * catalog. Both find the name id with find_name, as the commands do.
+ *
+ * Build from the repository root with:
+ *     gcc -O3 -Wall -Wextra -Werror -o bench_catalog tools/bench_catalog.c catalog.c vaccine.c date.c
+ *
+ * Add -march=native to let the compiler use AVX2 in the column kernels.
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../date.h"
+#include "../vaccine.h"
+#include "../catalog.h"
+
+#define BENCH_NAMES     20          /**< Number of vaccine names */
+#define BENCH_QUERIES   200000      /**< Default number of queries */
+#define BENCH_TODAY     200         /**< Day number of the present */
+#define BENCH_NAME      16          /**< Size of a generated vaccine name */
+
+
+/**
+ * @brief Next number of a linear congruential generator, so every run builds the same batches.
+ */
+static unsigned long next_random(unsigned long *seed) {
+    *seed = *seed * 6364136223846793005UL + 1442695040888963407UL;
+    return *seed >> 33;
+}
+
+
+/**
+ * @brief Finds the oldest eligible batch as `a` did, through search_vaccine.
+ *
+ * @return The batch, or NULL.
+ */
+static Vaccine *old_first_eligible(Vaccine *batch_list[], int entries, char *name, Date present) {
+    Vaccine *list[MAX_BRATCH];
+    int k, size = search_vaccine(batch_list, entries, name, list);
+
+    for (k = 0; k < size; k++) {
+        if (past_date(list[k]->date, present) > 0 && list[k]->dose > 0) return list[k];
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Finds the oldest eligible batch as `a` does, through the catalog.
+ *
+ * @return The batch, or NULL.
+ */
+static Vaccine *new_first_eligible(Catalog *catalog, Vaccine *batch_list[], int entries, char *name, int today) {
+    int k = catalog_first_eligible(catalog, entries, find_name(catalog, name), today);
+    return (k == NO_ELIGIBLE) ? NULL : batch_list[k];
+}
+
+
+int main(int argc, char **argv) {
+    Vaccine *batch_list[MAX_BRATCH], *list[MAX_BRATCH], **old_found, **new_found;
+    Catalog catalog;
+    char names[BENCH_NAMES][BENCH_NAME];
+    int found[MAX_BRATCH], *queries;
+    long i, count = BENCH_QUERIES, old_sum = 0, new_sum = 0;
+    int entries = 0, pos, today = BENCH_TODAY;
+    unsigned long seed = 1;
+    Date present = day_to_date(BENCH_TODAY);
+    Vaccine *batch;
+    clock_t start;
+    double times[4];
+
+    if (argc > 1) count = atol(argv[1]);
+    if (count < 1) {
+        fprintf(stderr, "usage: %s [<queries>]\n", argv[0]);
+        return 1;
+    }
+
+    start_catalog(&catalog);
+    for (i = 0; i < BENCH_NAMES; i++)
+        sprintf(names[i], "vac%ld", i);
+    for (i = 0; i < MAX_BRATCH; i++) {
+        batch = malloc(sizeof(Vaccine));
+        batch->name = malloc(BENCH_NAME);
+        strcpy(batch->name, names[next_random(&seed) % BENCH_NAMES]);
+        sprintf(batch->batch, "%lX", i);
+        pack_batch(batch->batch, &batch->key);
+        batch->date = day_to_date(next_random(&seed) % (3 * BENCH_TODAY));
+        batch->dose = (next_random(&seed) % 2) ? (int) (next_random(&seed) % 100) + 1 : 0;
+        pos = add_batch(batch_list, batch, entries);
+        catalog_insert(&catalog, pos, entries, batch);
+        entries++;
+    }
+    queries = malloc(sizeof(int) * count);
+    old_found = malloc(sizeof(Vaccine*) * count);
+    new_found = malloc(sizeof(Vaccine*) * count);
+    for (i = 0; i < count; i++)
+        queries[i] = next_random(&seed) % BENCH_NAMES;
+
+    start = clock();
+    for (i = 0; i < count; i++)
+        old_found[i] = old_first_eligible(batch_list, entries, names[queries[i]], present);
+    times[0] = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (i = 0; i < count; i++)
+        new_found[i] = new_first_eligible(&catalog, batch_list, entries, names[queries[i]], today);
+    times[1] = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (memcmp(old_found, new_found, sizeof(Vaccine*) * count) != 0) fprintf(stderr, "eligible batches differ\n");
+
+    start = clock();
+    for (i = 0; i < count; i++)
+        old_sum += search_vaccine(batch_list, entries, names[queries[i]], list);
+    times[2] = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (i = 0; i < count; i++)
+        new_sum += catalog_select(&catalog, entries, find_name(&catalog, names[queries[i]]), found);
+    times[3] = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (old_sum != new_sum) fprintf(stderr, "selected batches differ\n");
+
+    printf("batches %d names %d queries %ld\n", entries, BENCH_NAMES, count);
+    printf("a search_vaccine %.3f s %.1f ns/query\n", times[0], times[0] * 1e9 / count);
+    printf("a catalog_first_eligible %.3f s %.1f ns/query\n", times[1], times[1] * 1e9 / count);
+    printf("l search_vaccine %.3f s %.1f ns/query\n", times[2], times[2] * 1e9 / count);
+    printf("l catalog_select %.3f s %.1f ns/query\n", times[3], times[3] * 1e9 / count);
+
+    for (i = 0; i < entries; i++)
+        free_vaccine(batch_list[i]);
+    free_catalog(&catalog);
+    free(queries); free(old_found); free(new_found);
+    return 0;
+}
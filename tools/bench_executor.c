@@ -0,0 +1,157 @@
+/**
+ * @file bench_executor.c
+ * @brief Times the user lookups of `u <user>` commands with and without the read-ahead window.
+ *
+ * Fills the user table with more users than fit in cache (2000000 by
+ * default), writes a stream of `u <user>` commands naming random users, and
+ * times the lookups of the stream twice: one command at a time, as with
+ * `e 1`, and through the executor with a window, which hashes the names and
+ * prefetches ahead the way the main loop does. Both runs read the commands
+ * from the same file, so the time of reading them is in both.
+ *
+ * Build from the repository root with:
+ *     gcc -O3 -Wall -Wextra -Werror -Wno-unused-result -o bench_executor tools/bench_executor.c $(ls *.c | grep -v project.c)
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../date.h"
+#include "../inoculation.h"
+#include "../user.h"
+#include "../system.h"
+#include "../executor.h"
+
+#define BENCH_USERS     2000000     /**< Default number of users */
+#define BENCH_COMMANDS  4000000     /**< Default number of commands */
+#define BENCH_WINDOW    64          /**< Default window */
+#define BENCH_NAME      32          /**< Size of a generated user name */
+
+
+/**
+ * @brief Next number of a linear congruential generator, so every run names the same users.
+ */
+static unsigned long next_random(unsigned long *seed) {
+    *seed = *seed * 6364136223846793005UL + 1442695040888963407UL;
+    return *seed >> 33;
+}
+
+
+/**
+ * @brief Looks up the user of a `u <user>` command, as command_u does.
+ *
+ * @return 1 if the user exists.
+ */
+static int lookup(Sys *sys, char *buf) {
+    char *name = buf + 2;
+    User *user;
+
+    find_hash(sys->user, name, strcspn(name, "\n"), &user);
+    return user != NULL;
+}
+
+
+/**
+ * @brief Runs the commands one at a time.
+ *
+ * @return Number of users found.
+ */
+static long run_plain(Sys *sys, FILE *commands) {
+    char buf[MAXBUF];
+    long found = START;
+
+    rewind(commands);
+    while (fgets(buf, MAXBUF, commands))
+        found += lookup(sys, buf);
+    return found;
+}
+
+
+/**
+ * @brief Runs the commands through the executor, in windows.
+ *
+ * @return Number of users found.
+ */
+static long run_window(Sys *sys, FILE *commands) {
+    char buf[MAXBUF];
+    int i, count;
+    long found = START;
+
+    rewind(commands);
+    while (fgets(buf, MAXBUF, commands)) {
+        count = read_window(&sys->executor, buf, commands);
+        prefetch_window(&sys->executor, sys->user);
+        for (i = 0; i < count; i++) {
+            strcpy(buf, window_command(&sys->executor, i));
+            prepare_command(&sys->executor, sys->user, i, buf);
+            found += lookup(sys, buf);
+            sys->user->hint = NULL;
+        }
+    }
+    return found;
+}
+
+
+int main(int argc, char **argv) {
+    Sys sys;
+    FILE *commands;
+    LinkInl record;
+    char name[BENCH_NAME];
+    long i, users = BENCH_USERS, count = BENCH_COMMANDS, found;
+    int window = BENCH_WINDOW;
+    unsigned long seed = 1;
+    clock_t start;
+    double plain, windowed;
+
+    if (argc > 1) users = atol(argv[1]);
+    if (argc > 2) count = atol(argv[2]);
+    if (argc > 3) window = atoi(argv[3]);
+    if (users < 1 || count < 1 || window < 2 || window > MAX_WINDOW) {
+        fprintf(stderr, "usage: %s [<users> [<commands> [<window 2-%d>]]]\n", argv[0], MAX_WINDOW);
+        return 1;
+    }
+
+    start_sys(&sys, ENG);
+    for (i = 0; i < users; i++) {
+        sprintf(name, "user%ld", i);
+        record = new_record(sys.inolink);
+        record->date = sys.present;
+        insert_hash(sys.user, sys.inolink, record, name, strlen(name));
+    }
+    if ((commands = tmpfile()) == NULL) {
+        fprintf(stderr, "no temporary file\n");
+        return 1;
+    }
+    for (i = 0; i < count; i++)
+        fprintf(commands, "u user%lu\n", next_random(&seed) % users);
+
+    found = run_plain(&sys, commands);      /* Once untimed, to warm the file and the table */
+    start = clock();
+    run_plain(&sys, commands);
+    plain = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    set_window(&sys.executor, window);
+    start = clock();
+    if (run_window(&sys, commands) != found) fprintf(stderr, "lookups differ\n");
+    windowed = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("users %ld commands %ld found %ld\n", users, count, found);
+    printf("window 1 %.3f s %.1f ns/command\n", plain, plain * 1e9 / count);
+    printf("window %d %.3f s %.1f ns/command\n", window, windowed, windowed * 1e9 / count);
+
+    fclose(commands);
+    free_list_ino(sys.inolink);
+    free_user(sys.user);
+    free(sys.inolink);
+    free_catalog(&sys.catalog);
+    free_cache(&sys.cache);
+    free_history(&sys.history);
+    free_executor(&sys.executor);
+    free_archive(&sys.archive);
+    return 0;
+}
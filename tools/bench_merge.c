@@ -0,0 +1,200 @@
+/**
+ * @file bench_merge.c
+ * @brief Times the merge of `w` against reading a stream interleaved in advance and against sorting every line.
+ *
+ * Writes some clinic feeds (16 by default) of a year of days each, every day
+ * a `t` marker followed by some `a` commands, and gets them in date order
+ * three ways: through the heap of merge.c, as `w` does; by loading every line
+ * and sorting them by day, feed and position, as interleaving the files by
+ * hand would; and by reading one file that already holds the merged stream,
+ * the floor for any interleaving. Only the order of the lines is timed, no
+ * command runs.
+ *
+ * Build from the repository root with:
+ *     gcc -O3 -Wall -Wextra -Werror -Wno-unused-result -o bench_merge tools/bench_merge.c $(ls *.c | grep -v project.c)
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../date.h"
+#include "../system.h"
+#include "../merge.h"
+
+#define BENCH_FEEDS     16          /**< Default number of feeds */
+#define BENCH_DAYS      365         /**< Days of every feed */
+#define BENCH_PER_DAY   200         /**< Default commands per day of a feed */
+#define BENCH_LINES     4096        /**< Initial size of the table of lines of the sort */
+
+
+/**
+ * @brief A line of a feed, for the sort.
+ */
+typedef struct {
+    int day;                /**< Day of the last marker of its feed */
+    int feed;               /**< Its feed */
+    long pos;               /**< Its position in the feed */
+    char *text;             /**< The line */
+} Line;
+
+
+/**
+ * @brief Compares two lines by day, feed and position.
+ */
+static int comp_line(const void *a, const void *b) {
+    const Line *line1 = a, *line2 = b;
+
+    if (line1->day != line2->day) return line1->day - line2->day;
+    if (line1->feed != line2->feed) return line1->feed - line2->feed;
+    return (line1->pos > line2->pos) - (line1->pos < line2->pos);
+}
+
+
+/**
+ * @brief Rewinds the feeds.
+ */
+static void rewind_feeds(FILE *feeds[], int count) {
+    int i;
+    for (i = 0; i < count; i++)
+        rewind(feeds[i]);
+}
+
+
+/**
+ * @brief Merges the feeds with merge.c, writing the stream to a file when one is given.
+ *
+ * @return Number of bytes handed out.
+ */
+static long run_merge(FILE *feeds[], int count, Date present, FILE *out) {
+    Merge merge;
+    char *line;
+    long bytes = 0;
+
+    rewind_feeds(feeds, count);
+    start_merge(&merge, feeds, count, present);
+    while ((line = next_merged(&merge)) != NULL) {
+        bytes += strlen(line);
+        if (out != NULL) fputs(line, out);
+    }
+    free_merge(&merge);
+    return bytes;
+}
+
+
+/**
+ * @brief Loads every line of the feeds and sorts them.
+ *
+ * @return Number of bytes handed out.
+ */
+static long run_sort(FILE *feeds[], int count, Date present) {
+    char buf[MAXBUF];
+    int i, day, size = BENCH_LINES;
+    long n = 0, pos, bytes = 0;
+    Line *lines = malloc(sizeof(Line) * size);
+    Date date;
+
+    rewind_feeds(feeds, count);
+    for (i = 0; i < count; i++) {
+        day = date_to_day(present);
+        for (pos = 0; fgets(buf, MAXBUF, feeds[i]) != NULL; pos++) {
+            if (buf[0] == 't' && parse_date(buf + 2, &date) == VALID) day = date_to_day(date);
+            if (n == size) {
+                size *= 2;
+                lines = realloc(lines, sizeof(Line) * size);
+            }
+            lines[n].day = day;
+            lines[n].feed = i;
+            lines[n].pos = pos;
+            lines[n].text = malloc(strlen(buf) + 1);
+            strcpy(lines[n].text, buf);
+            n++;
+        }
+    }
+    qsort(lines, n, sizeof(Line), comp_line);
+    for (pos = 0; pos < n; pos++) {
+        bytes += strlen(lines[pos].text);
+        free(lines[pos].text);
+    }
+    free(lines);
+    return bytes;
+}
+
+
+/**
+ * @brief Reads a stream merged in advance.
+ *
+ * @return Number of bytes handed out.
+ */
+static long run_read(FILE *merged) {
+    char buf[MAXBUF];
+    long bytes = 0;
+
+    rewind(merged);
+    while (fgets(buf, MAXBUF, merged) != NULL)
+        bytes += strlen(buf);
+    return bytes;
+}
+
+
+int main(int argc, char **argv) {
+    FILE **feeds, *merged;
+    int i, d, c, count = BENCH_FEEDS, per_day = BENCH_PER_DAY;
+    long bytes;
+    Date present = day_to_date(0), date;
+    clock_t start;
+    double times[3];
+
+    if (argc > 1) count = atoi(argv[1]);
+    if (argc > 2) per_day = atoi(argv[2]);
+    if (count < 1 || per_day < 0) {
+        fprintf(stderr, "usage: %s [<feeds> [<commands per day>]]\n", argv[0]);
+        return 1;
+    }
+
+    feeds = malloc(sizeof(FILE*) * count);
+    for (i = 0; i < count; i++) {
+        if ((feeds[i] = tmpfile()) == NULL) {
+            fprintf(stderr, "no temporary file\n");
+            return 1;
+        }
+        for (d = 1; d <= BENCH_DAYS; d++) {
+            date = day_to_date(d);
+            fprintf(feeds[i], "t %s%d-%s%d-%d\n", Zero(date.day), date.day, Zero(date.month), date.month, date.year);
+            for (c = 0; c < per_day; c++)
+                fprintf(feeds[i], "a clinic%d_user%d vaccine%d\n", i, d * per_day + c, c % 7);
+        }
+    }
+    if ((merged = tmpfile()) == NULL) {
+        fprintf(stderr, "no temporary file\n");
+        return 1;
+    }
+    bytes = run_merge(feeds, count, present, merged);      /* Also warms the files */
+
+    start = clock();
+    if (run_merge(feeds, count, present, NULL) != bytes) fprintf(stderr, "merge lost lines\n");
+    times[0] = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    if (run_sort(feeds, count, present) != bytes) fprintf(stderr, "sort lost lines\n");
+    times[1] = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    if (run_read(merged) != bytes) fprintf(stderr, "read lost lines\n");
+    times[2] = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("feeds %d days %d commands per day %d bytes %ld\n", count, BENCH_DAYS, per_day, bytes);
+    printf("merge %.3f s\n", times[0]);
+    printf("sort %.3f s\n", times[1]);
+    printf("merged file %.3f s\n", times[2]);
+
+    for (i = 0; i < count; i++)
+        fclose(feeds[i]);
+    fclose(merged);
+    free(feeds);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file board_reader.c
+ * @brief Reads the catalog published with the g command.
+ *
+ * Prints the version of the board followed by its batches, or only those of
+ * one vaccine, in the format of the l command. It never writes to the board,
+ * so any number of readers can run while the program keeps publishing.
+ *
+ * Build from the repository root with:
+ *     gcc -O3 -Wall -Wextra -Werror -o board_reader tools/board_reader.c board.c
+ *
+ * @author Afonso Sítima - 114018
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../date.h"
+#include "../vaccine.h"
+#include "../board.h"
+
+
+int main(int argc, char **argv) {
+    FILE *file;
+    BoardHeader header;
+    BoardRecord *records;
+    int i, result;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <board> [<vaccine>]\n", argv[0]);
+        return 1;
+    }
+    if ((file = fopen(argv[1], "rb")) == NULL) {
+        fprintf(stderr, "%s: no such file\n", argv[1]);
+        return 1;
+    }
+    records = malloc(sizeof(BoardRecord) * MAX_BRATCH);
+    result = read_board(file, &header, records);
+    fclose(file);
+    if (result != VALID) {
+        fprintf(stderr, "%s: not a readable board\n", argv[1]);
+        free(records);
+        return 1;
+    }
+
+    printf("%llu\n", header.seq);
+    for (i = 0; i < header.entries; i++) {
+        if (argc > 2 && strcmp(records[i].name, argv[2]) != 0) continue;
+        printf("%s %s %s%d-%s%d-%d %d %d\n", records[i].name, records[i].batch,
+                Zero(records[i].day), records[i].day, Zero(records[i].month), records[i].month,
+                records[i].year, records[i].dose, records[i].uses);
+    }
+    free(records);
+    return 0;
+}
@@ -14,51 +14,129 @@
 #include "vaccine.h"
 #include "inoculation.h"
 #include "user.h"
+#include "cold.h"
 
 
-int hash(char *name) {
-    int i, length, hash_value = HASH;
-    length = strlen(name);
+int hash(char *name, int size) {
+    int i;
+    unsigned int hash_value = HASH;
     
-    for  (i = 0; i < length; i++) {
-        hash_value += name[i];
-        hash_value = (hash_value * name[i]);
+    for  (i = 0; i < size; i++) {
+        hash_value += (unsigned char) name[i];
+        hash_value = (hash_value * (unsigned char) name[i]);
     }
-    return abs(hash_value);
+    return hash_value >> 1;
 }
 
 
+/**
+ * @brief Hash of a name, taken from the hint when it is the name the executor already hashed.
+ */
+static int name_hash(HashTable *ht, char *name, int size) {
+    if (name == ht->hint && size == ht->hint_size) return ht->hint_hash;
+    return hash(name, size);
+}
+
 
+char *arena_copy(Arena *arena, char *name, int size) {
+    Chunk *chunk = arena->chunks;
+    char *copy;
 
-void insert_hash(HashTable *ht, LinkInl ino, char *name) {
-    int index;
+    if (chunk == NULL || chunk->size - chunk->used < size + 1) {    /* Opens a new block */
+        chunk = malloc(sizeof(Chunk) + (size + 1 > ARENA_CHUNK ? size + 1 : ARENA_CHUNK));
+        chunk->size = (size + 1 > ARENA_CHUNK) ? size + 1 : ARENA_CHUNK;
+        chunk->used = START;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+    copy = chunk->text + chunk->used;
+    memcpy(copy, name, size);
+    copy[size] = '\0';
+    chunk->used += size + 1;
+    return copy;
+}
+
+
+void free_arena(Arena *arena) {
+    Chunk *next;
+    while (arena->chunks != NULL) {
+        next = arena->chunks->next;
+        free(arena->chunks);
+        arena->chunks = next;
+    }
+}
+
+
+void insert_hash(HashTable *ht, Ino *inolink, LinkInl ino, char *name, int size) {
+    int i, index;
+    unsigned int *inos;
     User *user, *new_user;
     if (ht->count / ht->size > PERCENT) resize_hash(ht);
-    index = hash(name) % ht->size;
+    index = name_hash(ht, name, size) % ht->size;
     user = ht->user_list[index];
     while (user != NULL) {
-        if (strcmp(user->name, name) == 0) break;
+        if (user->size == size && memcmp(user->name, name, size) == 0) break;
         user = user->next;
     }
     if (user == NULL) {             /* First time seeing this user (creats a space for it) */      
         new_user = malloc(sizeof(User));
-        new_user->name = strdup(name);
-        ino->name = new_user->name;
-        new_user->ino_list = malloc(sizeof(LinkInl) * 40);
+        if (size < SHORT_NAME) {    /* Short names live inside the record */
+            memcpy(new_user->short_name, name, size);
+            new_user->short_name[size] = '\0';
+            new_user->name = new_user->short_name;
+        }
+        else {
+            new_user->name = arena_copy(&ht->names, name, size);
+        }
+        new_user->size = size;
+        new_user->capacity = INLINE_INOS;
         new_user->count = 0;
+        new_user->cold = 0;
         ht->count++;
         new_user->next = ht->user_list[index];  /* Add to the list */
         ht->user_list[index] = new_user;
         user = new_user;
     }
-    else {                          /* If there's already a user */
-        ino->name = user->name;     /* To make it easier to free and it takes less memory */
+    ino->name = user->name;         /* To make it easier to free and it takes less memory */
+    if (user->count == user->capacity) {    /* Grows geometrically */
+        if (user->capacity == INLINE_INOS) {
+            inos = malloc(sizeof(unsigned int) * INLINE_INOS * 2);
+            memcpy(inos, user->inos.local, sizeof(unsigned int) * INLINE_INOS);
+            user->inos.heap = inos;
+        }
+        else {
+            user->inos.heap = realloc(user->inos.heap, sizeof(unsigned int) * user->capacity * 2);
+        }
+        user->capacity *= 2;
+    }
+    inos = user_inos(user);
+    for (i = user->count++; i > 0 && past_date(RECORD(inolink, inos[i - 1])->date, ino->date) > 0; i--)
+        inos[i] = inos[i - 1];      /* Only a historical inoculation goes before newer ones */
+    inos[i] = ino->id;
+}
+
+
+unsigned int *user_inos(User *user) {
+    return (user->capacity == INLINE_INOS) ? user->inos.local : user->inos.heap;
+}
+
+
+void print_memory(HashTable *ht) {
+    int i;
+    long before = START, after = START;
+    User *user;
+
+    for (i = 0; i < ht->size; i++) {
+        for (user = ht->user_list[i]; user != NULL; user = user->next) {
+            before += sizeof(char*) * 2 + sizeof(int) * 2 + user->size + 1 +     /* Previous User record and name copy */
+                      sizeof(LinkInl) * OLD_SLOTS * ((user->count + OLD_SLOTS - 1) / OLD_SLOTS + (user->count == 0));
+            after += sizeof(User) + (user->size >= SHORT_NAME ? user->size + 1 : 0) +
+                     (user->capacity > INLINE_INOS ? sizeof(unsigned int) * user->capacity : 0);
         }
-    if (user->count != 0 && user->count % 40 == 0) {
-        user->ino_list = realloc(user->ino_list, sizeof(LinkInl) * (user->count + 40));
     }
-    free(name);
-    user->ino_list[user->count++] = ino;
+    printf("users %d\n", ht->count);
+    printf("before %ld %ld\n", before, ht->count ? before / ht->count : 0);
+    printf("after %ld %ld\n", after, ht->count ? after / ht->count : 0);
 }
 
 
@@ -74,7 +152,7 @@ void resize_hash(HashTable *ht) {
         user = ht->user_list[i];
         while (user != NULL) {      /* Going throught the linked list of users */
             next_user = user->next;
-            index = hash(user->name) % new_size;    
+            index = hash(user->name, user->size) % new_size;    
             user->next = new_list[index];   /* user turns into the head of new_list[index] (there can be other users already there) */
             new_list[index] = user;     
             user = next_user;   /* Continue to the next user of the list */
@@ -93,24 +171,24 @@ void free_user(HashTable *ht) {
         user = ht->user_list[i];
         while (user != NULL) {      /* Going throught the list */
             next = user->next;
-            free(user->name);
-            free(user->ino_list);
+            if (user->capacity > INLINE_INOS) free(user->inos.heap);
             free(user);
             user = next;
         }
     }
     free(ht->user_list);
+    free_arena(&ht->names);
     free(ht);
 }
 
 
-void find_hash(HashTable *ht, char *name, User **user) {
+void find_hash(HashTable *ht, char *name, int size, User **user) {
     int index;
     User *find;
-    index = hash(name) % ht->size;
+    index = name_hash(ht, name, size) % ht->size;
     find = ht->user_list[index];
     while (find != NULL) {
-        if (strcmp(find->name, name) == 0) { 
+        if (find->size == size && memcmp(find->name, name, size) == 0) { 
             *user = find;
             return;
         }
@@ -120,24 +198,29 @@ void find_hash(HashTable *ht, char *name, User **user) {
 }
 
 
-void print_user(User *user) {
+void print_user(Ino *inolink, User *user) {
     int i;
+    unsigned int *inos = user_inos(user);
+    LinkInl ino;
     for (i = 0; i < user->count; i++) {
-        printf("%s %s ", user->name, user->ino_list[i]->vaccine->batch);
-        print_date(user->ino_list[i]->date);
+        ino = RECORD(inolink, inos[i]);
+        printf("%s %s ", user->name, ino->vaccine->batch);
+        print_date(ino->date);
         printf("\n");
     }
 }
 
 
-int comp_inoculation(HashTable *ht, Date present, char *user_name, char *vaccine_name) {   
+int comp_inoculation(HashTable *ht, Ino *inolink, Date present, char *user_name, int size, char *vaccine_name) {   
    int i;
    User *user;
-   find_hash(ht, user_name, &user);
+   LinkInl ino;
+   find_hash(ht, user_name, size, &user);
    if (user == NULL) return VALID;
    for (i = 0; i < user->count; i++) {
-       if (strcmp(vaccine_name, user->ino_list[i]->vaccine->name) == VALID &&
-               past_date(user->ino_list[i]->date, present) == VALID) {
+       ino = RECORD(inolink, user_inos(user)[i]);
+       if (strcmp(vaccine_name, ino->vaccine->name) == VALID &&
+               past_date(ino->date, present) == VALID) {
                return INVALID;
        }
    }    
@@ -145,10 +228,10 @@ int comp_inoculation(HashTable *ht, Date present, char *user_name, char *vaccine
 }
 
 
-int remove_application(Ino *inolink, HashTable *ht, Date present, char *name, char *date, char *batch, int check) {
+int remove_application(Ino *inolink, HashTable *ht, Date present, char *name, int size, char *date, char *batch, int check) {
     User *user;
 
-    find_hash(ht, name, &user);
+    find_hash(ht, name, size, &user);
     switch (check){
         case ONLY_NAME:
             return remove_user(inolink, ht, user);  
@@ -164,9 +247,10 @@ int remove_user(Ino *inolink, HashTable *ht, User *user) {
     int i, count = START;
     if (user == NULL) return NO_USER_NUM;
     for (i = 0; i < user->count; i++) {
-        remove_inoculation(inolink, user->ino_list[i]);
+        remove_inoculation(inolink, RECORD(inolink, user_inos(user)[i]));
         count+=1;
     }
+    count += remove_cold(inolink, user, ALL_DAYS, NULL);
     remove_user_ptr(ht, user);
     return count;
 }
@@ -176,37 +260,39 @@ int remove_by_date(Ino *inolink, HashTable *ht, User *user, char *date, char* ba
     int i, count = START;
     Date check_date;
     LinkInl keep;
+    BatchKey key;
     if (user == NULL) return NO_USER_NUM;
+    if (num == WITH_BATCH) pack_batch(batch, &key);
     
-    read_date(date, &check_date, present);
-    if (past_date(check_date, present) > 0) return NUM_INV_DATE;
+    if (parse_date(date, &check_date) != VALID || past_date(check_date, present) > 0)
+        return NUM_INV_DATE;
     
     for (i = 0; i < user->count; i++) {
-        if (past_date(check_date, user->ino_list[i]->date) == 0) {
+        keep = RECORD(inolink, user_inos(user)[i]);
+        if (past_date(check_date, keep->date) == 0) {
             if (num != WITH_BATCH) {
-                keep = user->ino_list[i];
-                reorganize_array(user->ino_list, keep, user->count);
+                reorganize_array(user_inos(user), keep->id, user->count);
                 remove_inoculation(inolink, keep);
                 user->count--; count += 1; i--;
             }
             else {
-                if (strcmp(batch, user->ino_list[i]->vaccine->batch) == 0) {
-                    keep = user->ino_list[i];
-                    reorganize_array(user->ino_list, keep, user->count);
+                if (compare_batch(&key, batch, &keep->vaccine->key, keep->vaccine->batch) == 0) {
+                    reorganize_array(user_inos(user), keep->id, user->count);
                     remove_inoculation(inolink, keep);
                     user->count--; count += 1; i--;
                 }
             }
         } 
     }
+    count += remove_cold(inolink, user, date_to_day(check_date), num == WITH_BATCH ? batch : NULL);
     if (num == WITH_BATCH && count == 0) return NUM_NO_BATCH;
-    if (user->count <= 0) remove_user_ptr(ht, user);    /* If there's no inoculation, removes the user */
+    if (user->count + user->cold <= 0) remove_user_ptr(ht, user);    /* If there's no inoculation, removes the user */
     return count;
 }
 
 
 void remove_user_ptr(HashTable *ht, User *remove) {
-    int index = hash(remove->name) % ht->size;
+    int index = hash(remove->name, remove->size) % ht->size;
     User *prev = NULL;
     User *curr = ht->user_list[index];
     while (curr != NULL) {
@@ -216,8 +302,7 @@ void remove_user_ptr(HashTable *ht, User *remove) {
             } else {
                 prev->next = curr->next;
             }
-            free(curr->name);
-            free(curr->ino_list);
+            if (curr->capacity > INLINE_INOS) free(curr->inos.heap);
             free(curr);
             ht->count--;
             return;
@@ -31,19 +31,49 @@
 #define ONLY_NAME   0         /**< Flag for removal using only username */
 #define WITH_DATE   1         /**< Flag for removal using username and date */
 #define WITH_BATCH  2         /**< Flag for removal using username, date and batch */
+#define SHORT_NAME  24        /**< Names shorter than this are stored inside the User record */
+#define ARENA_CHUNK 65536     /**< Size of each block of the name arena */
+#define INLINE_INOS 2         /**< Inoculations stored inside the User record before using the heap */
+#define OLD_SLOTS   40        /**< Slots per step of the previous per-user inoculation array */
 
 #define NO_USER_NUM -1        /**< Error code: user does not exist */
 
 #define NO_USER(A) ((A == ENG) ? ": no such user" : ": utente inexistente") /**< Error message: user does not exist */
 
 
+/**
+ * @brief Block of the append-only arena that stores long user names.
+ */
+typedef struct chunk {
+    struct chunk *next;      /**< Previously filled block */
+    int used;                /**< Bytes already taken */
+    int size;                /**< Capacity of the block */
+    char text[];             /**< Stored names */
+} Chunk;
+
+
+/**
+ * @brief Append-only arena of user names that do not fit inside a User record.
+ */
+typedef struct {
+    Chunk *chunks;           /**< Block being filled (head of the list of blocks) */
+} Arena;
+
+
 /**
  * @brief Structure that stores user data.
  */
 typedef struct user {
-    char *name;              /**< User's name */
-    LinkInl *ino_list;       /**< Array of inoculations linked to the user */
-    int count;               /**< Number of inoculations the user has */
+    char *name;              /**< User's name (points to short_name or to the name arena) */
+    int size;                /**< Length of the name */
+    char short_name[SHORT_NAME];  /**< Inline storage for short names */
+    union {
+        unsigned int local[INLINE_INOS];  /**< Record indexes while they fit in the record */
+        unsigned int *heap;  /**< Record indexes once capacity exceeds INLINE_INOS */
+    } inos;                  /**< Indexes (in the record pool) of the user's inoculations */
+    int count;               /**< Number of inoculations the user has in memory */
+    int capacity;            /**< Number of indexes that fit in inos */
+    int cold;                /**< Number of inoculations of the user in the cold tier */
     struct user *next;       /**< Pointer to the next user in case of collision (linked list) */
 } User;
 
@@ -55,16 +85,40 @@ typedef struct hash {
     User **user_list;        /**< Array of pointers to user entries (buckets) */
     int size;                /**< Total size of the hash table */
     int count;               /**< Current number of users in the table */
+    Arena names;             /**< Storage of the long user names */
+    char *hint;              /**< Name of the command running whose hash is already known, or NULL */
+    int hint_size;           /**< Length of that name */
+    int hint_hash;           /**< Its hash */
 } HashTable;
 
 
 /**
  * @brief Calculates the hash index for a given user name.
  * 
- * @param name The name of the user.
+ * @param name The name of the user (not necessarily null-terminated).
+ * @param size Length of the name.
  * @return The computed hash index.
  */
-int hash(char *name);
+int hash(char *name, int size);
+
+
+/**
+ * @brief Copies a name into the arena.
+ *
+ * @param arena Pointer to the arena.
+ * @param name The name to copy (not necessarily null-terminated).
+ * @param size Length of the name.
+ * @return Pointer to the null-terminated copy, valid until the arena is freed.
+ */
+char *arena_copy(Arena *arena, char *name, int size);
+
+
+/**
+ * @brief Frees every block of the arena.
+ *
+ * @param arena Pointer to the arena.
+ */
+void free_arena(Arena *arena);
 
 
 /**
@@ -73,11 +127,38 @@ int hash(char *name);
  * If the user already exists, the inoculation is added to their list.
  * If not, a new user is created and added to the hash table.
  *
+ * The name is read directly from the input, it is only copied when a new
+ * user is created.
+ *
+ * The user's inoculations are kept in date order.
+ *
  * @param ht Pointer to the hash table.
+ * @param inolink Pointer to the inoculation manager (owns the records).
  * @param ino Pointer to the inoculation to insert.
- * @param name Name of the user.
+ * @param name Name of the user (not necessarily null-terminated).
+ * @param size Length of the name.
+ */
+void insert_hash(HashTable *ht, Ino *inolink, LinkInl ino, char *name, int size);
+
+
+/**
+ * @brief Returns the array of record indexes of a user.
+ *
+ * @param user Pointer to the user.
+ * @return Pointer to the first index (inside the record or on the heap).
+ */
+unsigned int *user_inos(User *user);
+
+
+/**
+ * @brief Prints the memory used by the per-user records, compared with the previous layout.
+ *
+ * The previous layout kept a pointer array with 40 slots per step and a
+ * heap copy of every name.
+ *
+ * @param ht Pointer to the hash table.
  */
-void insert_hash(HashTable *ht, LinkInl ino, char *name);
+void print_memory(HashTable *ht);
 
 
 /**
@@ -102,31 +183,35 @@ void free_user(HashTable *ht);
  * @brief Finds a user in the hash table by name.
  *
  * @param ht Pointer to the hash table.
- * @param name Name of the user to search.
+ * @param name Name of the user to search (not necessarily null-terminated).
+ * @param size Length of the name.
  * @param user Pointer to the result (NULL if not found).
  */
-void find_hash(HashTable *ht, char *name, User **user);
+void find_hash(HashTable *ht, char *name, int size, User **user);
 
 
 /**
  * @brief Prints all inoculations associated with a user.
  * 
+ * @param inolink Pointer to the inoculation manager (owns the records).
  * @param user Pointer to the user.
  */
-void print_user(User *user);
+void print_user(Ino *inolink, User *user);
 
 
 /**
  * @brief Checks whether a user has already received two inoculations of the same vaccine on or before the given date.
  *
  * @param ht Pointer to the hash table containing all users.
+ * @param inolink Pointer to the inoculation manager (owns the records).
  * @param present The current date to compare against the inoculation dates.
- * @param user_name The name of the user to check.
+ * @param user_name The name of the user to check (not necessarily null-terminated).
+ * @param size Length of the user name.
  * @param vaccine_name The name of the vaccine to check for.
  * @return int Returns 0 if the user already has two valid inoculations of the vaccine,
  *         otherwise returns 1.
  */
-int comp_inoculation(HashTable *ht, Date present, char *user_name, char *vaccine_name);
+int comp_inoculation(HashTable *ht, Ino *inolink, Date present, char *user_name, int size, char *vaccine_name);
 
 
 /**
@@ -174,13 +259,14 @@ int remove_by_date(Ino *inolink, HashTable *ht, User *user, char *date, char* ba
  * @param inolink Pointer to the inoculation manager.
  * @param ht Pointer to the hash table.
  * @param present Current date of the system.
- * @param name Name of the user.
+ * @param name Name of the user (not necessarily null-terminated).
+ * @param size Length of the name.
  * @param date (Optional) Date of the inoculation.
  * @param batch (Optional) Batch name of the inoculation.
  * @param check Removal mode indicator.
  * @return Number of removals or an error code.
  */
-int remove_application(Ino *inolink, HashTable *ht, Date present, char *name, char *date, char *batch, int check);
+int remove_application(Ino *inolink, HashTable *ht, Date present, char *name, int size, char *date, char *batch, int check);
 
 
 
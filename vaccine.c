@@ -22,6 +22,54 @@
 #include "system.h"
 
 
+/**
+ * @brief For each UTF-8 continuation byte (minus UTF8_TAIL), tells whether it
+ * completes, after ACCENT_LEAD, one of the letters of VALID_CHAR.
+ *
+ * Written by hand as a mirror of VALID_CHAR: a letter added to or removed from
+ * VALID_CHAR must be added to or removed from this table too.
+ */
+static const unsigned char accent_tail[64] = {
+    1, 1, 1, 1, 0, 0, 0, 1, 1, 1, 1, 0, 1, 1, 1, 0,
+    0, 0, 1, 1, 1, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0,
+    1, 1, 1, 1, 0, 0, 0, 1, 1, 1, 1, 0, 1, 1, 1, 0,
+    0, 0, 1, 1, 1, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0,
+};
+
+
+/**
+ * @brief Counts the bytes of a string that are not uppercase hexadecimal digits.
+ *
+ * Branch-free, so the compiler processes 16 (or 32) bytes per step.
+ */
+static int count_not_hex(const unsigned char *s, int size) {
+    int i, bad = 0;
+    for (i = 0; i < size; i++)
+        bad += ((unsigned char) (s[i] - '0') > 9) & ((unsigned char) (s[i] - 'A') > 5);
+    return bad;
+}
+
+
+/**
+ * @brief Counts the bytes of a string that are not ASCII name characters.
+ *
+ * Branch-free, so the compiler processes 16 (or 32) bytes per step.
+ */
+static int count_not_plain(const unsigned char *s, int size) {
+    int i, bad = 0;
+    unsigned char c, letter, digit, dash, under;
+    for (i = 0; i < size; i++) {
+        c = s[i];
+        letter = (unsigned char) ((c | 0x20) - 'a') <= 25;
+        digit = (unsigned char) (c - '0') <= 9;
+        dash = (unsigned char) ((c ^ '-') - 1) >> 7;    /* 1 when c is '-' (or a non-ASCII byte) */
+        under = (unsigned char) ((c ^ '_') - 1) >> 7;   /* 1 when c is '_' (or a non-ASCII byte) */
+        bad += (letter | digit | ((dash | under) & ((c >> 7) ^ 1))) ^ 1;
+    }
+    return bad;
+}
+
+
 
 
 void read_vaccine(Vaccine *batch_list[], Vaccine *new_vaccine, int num, int *error, char *buf, Date present) {
@@ -38,28 +86,28 @@ void read_vaccine(Vaccine *batch_list[], Vaccine *new_vaccine, int num, int *err
         *error = NUM_INV_BATCH; return;
     }
 
-    new_vaccine->batch = (char*) malloc((strlen(segment) + 1) * sizeof(char));
     strcpy(new_vaccine->batch, segment); 
+    pack_batch(new_vaccine->batch, &new_vaccine->key);
 
     segment = strtok(NULL, SPACE); //date
     
     if (read_date(segment, &date, present) != VALID) {
-        free(new_vaccine->batch); *error = NUM_INV_DATE; return;
+        *error = NUM_INV_DATE; return;
     }
     new_vaccine->date = date;  
     
     segment = strtok(NULL, SPACE); //dose
     if (check_inv_qnt(segment, &dose) != VALID) {
-        free(new_vaccine->batch); *error = NUM_INV_QNT; return;
+        *error = NUM_INV_QNT; return;
     }
 
     new_vaccine->dose = dose;
     segment = strtok(NULL, SPACE); //name
+    if (segment != NULL) segment[strcspn(segment, "\n")] = '\0';
     if (check_inv_name(segment) != VALID) {
-        free(new_vaccine->batch); *error = NUM_INV_NAME; return;
+        *error = NUM_INV_NAME; return;
     }
 
-    segment[strcspn(segment, "\n")] = '\0';
     new_vaccine->name = strdup(segment);
 }
 
@@ -73,7 +121,7 @@ int binary_search(Vaccine *batch_list[], int entries, Vaccine *target) {
         if (date_cmp < 0) right = mid;
         else if (date_cmp > 0) left = mid + 1;
         else {
-            if (strcmp(target->batch, batch_list[mid]->batch) < 0) {
+            if (compare_batch(&target->key, target->batch, &batch_list[mid]->key, batch_list[mid]->batch) < 0) {
                 right = mid;
             } 
             else {
@@ -86,15 +134,17 @@ int binary_search(Vaccine *batch_list[], int entries, Vaccine *target) {
 }
 
 
-void add_batch(Vaccine *batch_list[], Vaccine* batch, int entries) {
+int add_batch(Vaccine *batch_list[], Vaccine* batch, int entries) {
     int i, index = binary_search(batch_list, entries, batch);
     
     for (i = entries; i > index; i--)
         batch_list[i] = batch_list[i - 1];
 
     batch->uses = START;
+    batch->first_ino = NULL;
+    batch->last_ino = NULL;
     batch_list[index] = batch;
-
+    return index;
 } 
 
 
@@ -110,12 +160,50 @@ int search_vaccine(Vaccine *batch_list[], int entries, char *name, Vaccine *sear
 }
 
 
+int pack_batch(char *batch, BatchKey *key) {
+    int i, nibble;
+    unsigned long long *word;
+
+    key->hi = 0;
+    key->lo = 0;
+    for (i = 0; batch[i] != '\0'; i++) {
+        if (isdigit((unsigned char) batch[i])) nibble = batch[i] - '0';
+        else if (batch[i] >= 'A' && batch[i] <= ASCII_BATCH) nibble = batch[i] - 'A' + 10;
+        else break;
+        if (i >= BATCH_SIZE - 1) break;
+
+        word = (i < HI_NIBBLES) ? &key->hi : &key->lo;
+        *word |= (unsigned long long) nibble << (64 - NIBBLE_BITS * (i % HI_NIBBLES + 1));
+    }
+    if (batch[i] != '\0') {        /* Does not fit, compared as a string */
+        key->hi = 0;
+        key->lo = LOOSE_KEY;
+        return INVALID;
+    }
+    key->lo |= (unsigned long long) i;
+    return VALID;
+}
+
+
+int compare_batch(BatchKey *key1, char *batch1, BatchKey *key2, char *batch2) {
+    if (key1->lo == LOOSE_KEY || key2->lo == LOOSE_KEY)
+        return strcmp(batch1, batch2);
+    if (key1->hi != key2->hi)
+        return (key1->hi < key2->hi) ? -1 : 1;
+    if (key1->lo != key2->lo)
+        return (key1->lo < key2->lo) ? -1 : 1;
+    return 0;
+}
+
+
 int check_dup_batch(Vaccine *batch_list[], char *batch, int num_batch) {
     int i;
+    BatchKey key;
     if (batch == NULL) return NUM_INV_BATCH;
 
+    pack_batch(batch, &key);
     for (i = 0; i < num_batch; i++) {
-        if (strcmp(batch_list[i]->batch, batch) == 0) 
+        if (compare_batch(&batch_list[i]->key, batch_list[i]->batch, &key, batch) == 0) 
             return NUM_DUP_BATCH;
     }
     return VALID;
@@ -123,44 +211,44 @@ int check_dup_batch(Vaccine *batch_list[], char *batch, int num_batch) {
 
 
 int check_inv_batch(char *batch) {
-    int i, size;
+    int size = strlen(batch);
 
-    if ((size = strlen(batch)) > BATCH_SIZE - 1)
+    if (size > BATCH_SIZE - 1)
+        return NUM_INV_BATCH;
+    if (count_not_hex((unsigned char *) batch, size) != 0)
         return NUM_INV_BATCH;
-    for (i = 0; i < size; i++) {
-        if (batch[i] > ASCII_BATCH)
-            return NUM_INV_BATCH;
-    }
     return VALID;
 }
 
 
-int is_valid_char(char c) {
-    int i;
-    static const char acentos[] = VALID_CHAR;
+int is_valid_char(char *name, int *i) {
+    unsigned char c = name[*i], tail = name[*i + 1];
 
-    if (isalpha(c) || c == '-' || c == '_' || !isspace(c))
-        return NUM_INV_NAME;
-    
-    for (i = 0; acentos[i] != '\0'; i++) {
-        if (c == acentos[i])
-            return VALID;
+    if (c < ASCII_LIMIT) {
+        if (!isalnum(c) && c != '-' && c != '_')
+            return NUM_INV_NAME;
+        (*i)++;
+        return VALID;
     }
-    return NUM_INV_NAME;
+    if (c != ACCENT_LEAD || tail < UTF8_TAIL || tail >= UTF8_TAIL + 64 || !accent_tail[tail - UTF8_TAIL])
+        return NUM_INV_NAME;
+    *i += 2;
+    return VALID;
 }
 
 
 int check_inv_name(char *name) {
-    int i, size; 
+    int i = START, size; 
 
     if (name == NULL) return NUM_INV_NAME;
 
-    if ((size = strlen(name)) > NAME_SIZE - 1) 
+    if ((size = strlen(name)) > NAME_SIZE - 1 || size == 0) 
         return NUM_INV_NAME;
-    for (i = 0; i < size; i++) { 
-        if (is_valid_char(name[i]) == 0) {
-            return NUM_INV_NAME;  
-            }
+    if (count_not_plain((unsigned char *) name, size) == 0)
+        return VALID;
+    while (i < size) {              /* Has other bytes, checks the UTF-8 sequences */
+        if (is_valid_char(name, &i) != VALID)
+            return NUM_INV_NAME;
     }
     return VALID; 
 } 
@@ -177,7 +265,6 @@ int check_inv_qnt(char *segment, int *dose) {
 
 void free_vaccine(Vaccine *vaccine) {
     free(vaccine->name);
-    free(vaccine->batch);
     free(vaccine);
 }
 
@@ -213,7 +300,7 @@ void remove_batch(Vaccine *batch_list[], int *entries, int pos) {
 
 int comp(Vaccine *vaccine1, Vaccine *vaccine2) {
     if (past_date(vaccine1->date, vaccine2->date) == VALID) {
-        return strcmp(vaccine1->batch, vaccine2->batch);
+        return compare_batch(&vaccine1->key, vaccine1->batch, &vaccine2->key, vaccine2->batch);
     }
     return past_date(vaccine1->date, vaccine2->date);
 }
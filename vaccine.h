@@ -30,6 +30,10 @@
 #define VALID       0       /**< Valid statment */
 #define INVALID     1       /**< Inalid statment */  
 
+#define NIBBLE_BITS 4       /**< Bits used by each packed batch character */
+#define HI_NIBBLES  16      /**< Batch characters packed in the high word of a key */
+#define LOOSE_KEY   0xFFu   /**< Length field of a key whose batch code could not be packed */
+
 #define menor(a,b) ((a < b && a != 0) ? a : b) /**< Returns the smaller of two values, ignoring zero */
 
 /* Vaccine Errors */
@@ -42,19 +46,44 @@
 #define NUM_NO_BATCH   -2   /**< Error code: batch not found */
 
 #define VALID_CHAR  "áéíóúãõâêîôûàèìòùçÁÉÍÓÚÃÕÂÊÎÔÛÀÈÌÒÙÇ" /**< Accepted special characters in vaccine names */
+#define ACCENT_LEAD 0xC3    /**< UTF-8 lead byte shared by every character of VALID_CHAR */
+#define UTF8_TAIL   0x80    /**< First UTF-8 continuation byte */
+#define ASCII_LIMIT 0x80    /**< First byte value outside ASCII */
 
  
 
 
+struct inoculation;
+
+
+/**
+ * @brief Packed 128-bit key of a batch code.
+ *
+ * Hexadecimal codes are stored one nibble per character, left aligned, with
+ * the length in the low bits, so comparing the two words gives the same
+ * order as strcmp on the codes. Other codes get the LOOSE_KEY length and are
+ * compared as strings.
+ */
+typedef struct {
+    unsigned long long hi;  /**< First 16 characters */
+    unsigned long long lo;  /**< Last 4 characters and the length */
+} BatchKey;
+
+
 /**
  * @brief Structure representing a vaccine batch.
  */
 typedef struct vaccine {
     char *name;      /**< Vaccine name (up to 50 characters) */
-    char *batch;     /**< Unique batch code (up to 20 characters) */
+    char batch[BATCH_SIZE];  /**< Unique batch code (up to 20 characters) */
+    BatchKey key;    /**< Packed key of the batch code */
     Date date;       /**< Expiration date of the batch */
     int dose;        /**< Number of doses available */
     int uses;        /**< Number of doses already used */
+    struct inoculation *first_ino;  /**< Oldest inoculation given from this batch (reverse index) */
+    struct inoculation *last_ino;   /**< Newest inoculation given from this batch (reverse index) */
+    int version;     /**< Position of its version in the history */
+    int name_id;     /**< Id of its name in the catalog */
 } Vaccine;
 
 
@@ -74,6 +103,28 @@ typedef struct vaccine {
  */
 int binary_search(Vaccine *batch_list[], int entries, Vaccine *target);
 
+/**
+ * @brief Packs a batch code into its 128-bit key.
+ *
+ * @param batch The batch code.
+ * @param key Pointer to the key to fill.
+ * @return VALID if the code was packed, INVALID if it falls back to string comparison.
+ */
+int pack_batch(char *batch, BatchKey *key);
+
+
+/**
+ * @brief Compares two batch codes, using their packed keys when both are packed.
+ *
+ * @param key1 Key of the first code.
+ * @param batch1 First code.
+ * @param key2 Key of the second code.
+ * @param batch2 Second code.
+ * @return Negative, zero or positive, with the same sign as strcmp(batch1, batch2).
+ */
+int compare_batch(BatchKey *key1, char *batch1, BatchKey *key2, char *batch2);
+
+
 /**
  * @brief Checks if a batch code is already present in the batch list.
  * 
@@ -87,6 +138,9 @@ int check_dup_batch(Vaccine *batch_list[], char *batch, int num_batch);
 
 /**
  * @brief Validates the format of a batch code.
+ *
+ * A batch code has 1 to 20 uppercase hexadecimal digits. The whole code is
+ * classified by a branch-free loop that the compiler vectorizes.
  * 
  * @param batch The batch code string to validate.
  * @return 0 if valid, error code otherwise.
@@ -95,16 +149,23 @@ int check_inv_batch(char *batch);
 
 
 /**
- * @brief Checks whether a character is valid in a vaccine name.
+ * @brief Checks whether the character starting at a position of a vaccine name is valid.
+ *
+ * Accepts ASCII letters, digits, '-', '_' and the accented letters of
+ * VALID_CHAR, read as two-byte UTF-8 sequences through a lookup table.
  * 
- * @param c Character to validate.
+ * @param name Vaccine name.
+ * @param i Pointer to the position of the character, moved past it when valid.
  * @return 0 if valid, error code otherwise.
  */
-int is_valid_char(char c);
+int is_valid_char(char *name, int *i);
 
 
 /**
  * @brief Validates the format of a vaccine name.
+ *
+ * Names with only ASCII name characters are accepted by a single vectorized
+ * pass; names with other bytes are then checked character by character.
  * 
  * @param name The vaccine name to check.
  * @return 0 if valid, error code otherwise.
@@ -143,8 +204,9 @@ void read_vaccine(Vaccine *batch_list[], Vaccine *new_vaccine, int num, int *err
  * @param batch_list The array of vaccine pointers.
  * @param batch Pointer to the new vaccine to insert.
  * @param entries The current number of entries in the batch_list.
+ * @return The index where the vaccine was inserted.
  */
-void add_batch(Vaccine *batch_list[], Vaccine *batch, int entries); 
+int add_batch(Vaccine *batch_list[], Vaccine *batch, int entries); 
 
 
 /**